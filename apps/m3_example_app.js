@@ -11,6 +11,10 @@
   - Each incoming HTTP request is parsed and passed as a JS object to the callback.
   - The server must correctly handle the 'Content-Length:' header to determine the size of the request body.
   - The server must handle arbitrary incoming request sizes (not limited to a fixed buffer size).
+  - Every response closes its connection unless { keepAlive: true } is passed as a third argument. Then a
+    connection stays with the worker that served it, as long as the next request arrives within 100 ms;
+    the worker serves nothing else while it waits. Workers with nothing to do steal queued connections
+    from busy ones. Pipelined requests are served in order by the same worker.
   - The JS callback returns an object with the following structure:
       {
         status: <number>,           // HTTP status code (e.g., 200)
@@ -48,6 +52,15 @@
     - The server uses a thread pool to process requests in parallel.
     - Each request is handled in a separate thread.
     - JavaScript execution does not happen in parallel. Access to V8 must be synchronized and managed carefully.
+    - Passing { isolatePerWorker: true } as a third argument gives every worker its own isolate with this
+      script loaded into it, so handlers do run in parallel. Globals (like 'counter') are then per worker.
+    - { acceptPerWorker: true } gives every worker its own listening socket on the port (SO_REUSEPORT),
+      so connections are accepted by the worker that serves them instead of one accept thread. Adding
+      steerToCpu: true pins worker i to CPU i and hands each connection to the worker on the CPU that
+      received it; use it with one worker per core.
+    - { jsExecutor: true } runs every handler call on one dedicated thread instead of letting each
+      worker take the V8 lock in turn. Workers only read, parse and write; the executor takes all
+      requests waiting at that moment as one batch, which keeps the isolate hot on a single core.
 
   To test with curl:
   ------------------
@@ -74,14 +87,12 @@ function getBody(request) {
 ASP.createThreadPoolServer(request => {
     return {
         status: 200,
-        headers: {
-            'Content-Type': 'application/json'
-        },
-        body: JSON.stringify({
+        // ::: An object body is serialized to JSON by the server, with a JSON Content-Type.
+        body: {
             message: getBody(request),
             method: request.method,
             body: request.body
-        })
+        }
     };
 }, 8080);
 
@@ -20,7 +20,7 @@
       {
         status: <number>,           // HTTP status code (e.g., 200)
         headers: <object>,          // HTTP headers as key-value pairs
-        body: <string>              // Response body (string)
+        body: <string>              // Response body (string; an object or array is sent as JSON)
       }
   - The server serializes this object into a proper HTTP response.
   - The request object passed to the callback contains:
@@ -28,6 +28,12 @@
       - method: HTTP method (e.g., 'GET', 'POST')
       - size: size of the request body (if any, as determined by 'Content-Length')
       - body: the request body as a string (if any)
+      - json: the body parsed as JSON, for 'Content-Type: application/json' requests (parsed on first use)
+      - headers: the request headers; lookups ignore case (request.headers['content-type'])
+      - query: the query string as an object (e.g. '/search?q=a+b' gives { q: 'a b' })
+    body, headers and query are only turned into JS values when first read. An async handler may still
+    read them after an await (they are copied when it suspends), but a request object kept past the
+    handler any other way, e.g. in a timer callback, reads them as undefined.
 
   Example incoming request:
   ------------------------
@@ -50,15 +56,47 @@
       body: '<html>...</html>'
     }
 
+  Routes:
+  -------
+    ASP.route(method, pattern, fn) registers `fn` for one method ('GET', 'POST', ... or '*' for all) and
+    URL pattern. ':name' matches one path segment and '*name' the rest of the path; the values arrive in
+    request.params. Routes are looked up natively before any JS runs. Requests that match no route go to
+    the createEventLoopServer handler, or, when that handler is null, are answered 404 / 405 without
+    entering JS at all.
+      ASP.route('GET', '/users/:id', request => ({ status: 200, body: { id: request.params.id } }));
+      ASP.createEventLoopServer(null, 8080);
+
+  Static files:
+  -------------
+    ASP.static(urlPrefix, directory) serves GET / HEAD requests under urlPrefix from directory ('/' maps to
+    index.html) with sendfile, before routes and without entering JS. Open files are cached and rechecked
+    at most once a second. A handler can send a file itself by returning { body: { file: path } }.
+      ASP.static('/assets', './public');
+
+  Batch handler:
+  --------------
+    ASP.createBatchServer(handler, port, { maxBatch: N }) takes the place of createEventLoopServer. The
+    handler is called once per event loop round with an array of all the requests read in that round
+    (at most maxBatch, default and maximum 64) and returns an array of responses in the same order. A
+    missing or malformed element fails only its own request with a 500. Routes and static files are still
+    answered one request at a time. Request objects are read in full before the call, and an async batch
+    handler must settle without waiting on timers or I/O.
+      ASP.createBatchServer(requests => requests.map(request => ({ status: 200, body: request.path })), 8080);
+
   Event Loop & Concurrency:
   ------------------------
     - The server uses an event loop (e.g., epoll) to multiplex I/O.
     - No threads are used for request handling; all concurrency is via non-blocking events.
     - Shared state (like the 'counter' variable) is safe to use as all JS callbacks run on the event loop thread.
+    - Passing { reactors: N } as a third argument runs N event loops, one per thread, each with its own
+      isolate and listening socket (SO_REUSEPORT). Every connection stays on the loop that accepted it.
+      Globals (like 'counter') are then per reactor. Timers set by the script itself only run on the first
+      one; timers set by a handler run on the reactor that handler runs on.
 
   To test with curl:
   ------------------
     curl -v http://localhost:8080/index.html
+    curl -v http://localhost:8080/counter/5
     curl -v -d 'hello world' http://localhost:8080/index.html
     (The server will respond with an HTML page containing the request info and a counter value.)
     curl -v --header 'Connection: keep-alive' http://localhost:8080/index.html
@@ -82,6 +120,11 @@ function getBody(request) {
     `;
 };
 
+ASP.route('GET', '/counter/:step', request => ({
+    status: 200,
+    body: { counter: counter += Number(request.params.step) || 0 }
+}));
+
 ASP.createEventLoopServer(request => {
     if (request.path === '/favicon.ico') {
         return {
@@ -105,14 +148,13 @@ ASP.createEventLoopServer(request => {
     return {
         status: 200,
         headers: {
-            'Content-Type': 'application/json',
             'Connection': 'close'
         },
-        body: JSON.stringify({
+        body: {
             path: request.path,
             method: request.method,
-            body: request.body
-        })
+            body: request.json ?? request.body
+        }
     };
 }, 8080);
 
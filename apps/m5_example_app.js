@@ -13,12 +13,9 @@ ASP.createEventLoopServer(req => {
     if (req && req.url === "/telemetry") {
         return {
             status: 200,
-            headers: {
-                'Content-Type': 'application/json'
-            },
-            body: JSON.stringify({
+            body: {
                 requests: 42
-            })
+            }
         };
     } else {
         return {
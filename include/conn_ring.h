@@ -0,0 +1,81 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef CONN_RING_H
+#define CONN_RING_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bounded lock-free multi-producer / multi-consumer queue of file descriptors (Vyukov's ring): every slot
+ * carries a sequence number that tells a producer or consumer whether the slot is its turn, so a push or a
+ * pop is one compare-and-swap on a position counter plus a store, and never takes a lock.
+ *
+ * A consumer that finds the ring empty spins for a while, then parks on a futex; producers only make the
+ * wake system call when someone is actually parked. The acceptor of the thread-pool server pushes accepted
+ * connections, and the workers pop them.
+ */
+#define CONN_RING_CACHE_LINE 64
+
+typedef struct {
+    _Atomic size_t seq;
+    int fd;
+} ConnRingSlot;
+
+typedef struct {
+    ConnRingSlot *slots;
+    size_t mask;
+    int spin_rounds;                                         /* 0 on a single CPU, where spinning is futile */
+    alignas(CONN_RING_CACHE_LINE) _Atomic size_t enqueue_pos;
+    alignas(CONN_RING_CACHE_LINE) _Atomic size_t dequeue_pos;
+    alignas(CONN_RING_CACHE_LINE) _Atomic uint32_t wake_seq; /* Futex word, bumped on every wake */
+    _Atomic int waiters;                                     /* Consumers parked or about to park */
+    _Atomic int closed;
+} ConnRing;
+
+/* `capacity` must be a power of two. 0 on success, -1 if the slots could not be allocated. */
+int conn_ring_init(ConnRing *ring, size_t capacity);
+
+void conn_ring_destroy(ConnRing *ring);
+
+/* Non-blocking; 0 on success, -1 when the ring is full. */
+int conn_ring_try_push(ConnRing *ring, int fd);
+
+/* Pushes `fd`, yielding the CPU while the ring is full. -1 if the ring was closed first. */
+int conn_ring_push(ConnRing *ring, int fd);
+
+/* Non-blocking; the fd, or -1 when the ring is empty. */
+int conn_ring_try_pop(ConnRing *ring);
+
+/* Waits, spinning and then parking, until the ring looks non-empty or conn_ring_notify is called. It does not
+ * pop: returns 0 to have the caller look for work again, or -1 once the ring is closed and drained. */
+int conn_ring_wait(ConnRing *ring);
+
+/* Wakes one consumer parked in conn_ring_wait, if any, for work that turns up outside the ring. */
+void conn_ring_notify(ConnRing *ring);
+
+/* Wakes every parked consumer; pops drain what is left, then return -1. */
+void conn_ring_close(ConnRing *ring);
+
+#endif // CONN_RING_H
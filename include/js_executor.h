@@ -0,0 +1,64 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef JS_EXECUTOR_H
+#define JS_EXECUTOR_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "v8_api_access.h"
+
+/**
+ * A dedicated thread that owns the shared isolate and runs every handler call. I/O threads submit a job and
+ * wait for it; the executor takes everything submitted so far in one go and runs it as a single batch under
+ * one v8::Locker (v8_dispatch_batch), so the isolate's heap and JIT state stay on one core instead of moving
+ * to whichever worker took the lock last.
+ *
+ * Submissions go onto a lock-free stack; the executor swaps the whole stack out and reverses it, which gives
+ * it the batch in arrival order. Both sides spin briefly before sleeping on a futex.
+ */
+typedef struct JsExecutorJob {
+    JSDispatchJob dispatch;
+    struct JsExecutorJob *next;
+    _Atomic uint32_t state; /* JOB_PENDING, JOB_DONE or JOB_WAITING (js_executor.c) */
+} JsExecutorJob;
+
+typedef struct {
+    V8Engine *engine;
+    pthread_t thread;
+    int spin_iterations;       /* 0 on a single CPU, where spinning is futile */
+    _Atomic(JsExecutorJob *) submitted;
+    _Atomic uint32_t sleeping; /* Futex word: 1 while the executor is parked */
+    _Atomic int stopping;
+} JsExecutor;
+
+/* Starts the executor thread on `engine`. 0 on success, -1 if the thread could not be created. */
+int js_executor_start(JsExecutor *executor, V8Engine *engine);
+
+/* Runs the handler for `request` on the executor and waits for it. Same contract as v8_dispatch_request. */
+JSDispatchResult js_executor_dispatch(JsExecutor *executor, JSRequest *request, JSResponse *response);
+
+/* Finishes the jobs already submitted, then joins the thread. */
+void js_executor_stop(JsExecutor *executor);
+
+#endif // JS_EXECUTOR_H
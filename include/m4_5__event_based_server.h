@@ -36,21 +36,22 @@ extern "C" {
 #endif
 
 
-typedef struct {
-    char *name;
-    char *value;
-} EvHttpHeader;
-
 #define MAX_HEADERS 32
 
 typedef struct {
     char *method;
     char *path;
     char *body;
-    EvHttpHeader headers[MAX_HEADERS];
+    size_t body_size;
+    JSHeader headers[MAX_HEADERS]; /* Slices into the read buffer, which outlives the request */
     int header_count;
+    int http_1_1;                  /* Request line says HTTP/1.1, which makes Host mandatory */
 } EvHttpRequest;
 
-void register_js_interval_callback(int ms, JSObject cb);
+/* setInterval / setTimeout: takes ownership of `cb`, returns the timer id (0 on failure). */
+int register_js_timer(int ms, int repeat, JSObject cb);
+
+/* clearInterval / clearTimeout */
+void cancel_js_timer(int id);
 
 #endif // EVENT_BASED_SERVER_H
@@ -0,0 +1,107 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Radix trie of URL patterns, used by ASP.route. Static runs of a pattern are stored as compressed edges that
+ * are split when a later pattern diverges inside them. `:name` matches one non-empty path segment; `*name`,
+ * only allowed at the end, matches the rest of the path. A lookup tries the static edge first, then the
+ * parameter, then the wildcard, and backtracks on a dead end, so "/users/me" wins over "/users/:id"
+ * whichever was registered first.
+ *
+ * Handlers are ints chosen by the caller; the bridge registers indices into its own table of JS functions.
+ * Lookups never allocate: parameter values are slices of the path that was looked up.
+ */
+#define ROUTE_MAX_PARAMS 16
+
+typedef enum {
+    ROUTE_GET,
+    ROUTE_HEAD,
+    ROUTE_POST,
+    ROUTE_PUT,
+    ROUTE_DELETE,
+    ROUTE_PATCH,
+    ROUTE_OPTIONS,
+    ROUTE_METHOD_COUNT
+} RouteMethod;
+
+typedef enum {
+    ROUTE_FOUND,
+    ROUTE_NOT_FOUND,
+    ROUTE_METHOD_NOT_ALLOWED
+} RouteResult;
+
+typedef struct RouteNode RouteNode;
+
+typedef struct {
+    RouteNode *root;
+    size_t count; /* Registered (method, pattern) pairs */
+} RouteTable;
+
+typedef struct {
+    const char *name;  /* NUL-terminated, owned by the table */
+    const char *value; /* Points into the looked-up path; not NUL-terminated */
+    size_t value_len;
+} RouteParam;
+
+typedef struct {
+    int handler; /* -1 unless ROUTE_FOUND */
+    int param_count;
+    RouteParam params[ROUTE_MAX_PARAMS];
+    unsigned allowed; /* ROUTE_METHOD_NOT_ALLOWED: one bit per RouteMethod the path does have */
+} RouteMatch;
+
+void route_table_init(RouteTable *table);
+
+void route_table_free(RouteTable *table);
+
+/* Maps "GET", "POST", ... (in any case) to a RouteMethod, or returns -1. */
+int route_method_parse(const char *method, size_t len);
+
+/* Registers `handler` for `method` ("GET", ..., or "*" for all of them) on `pattern`, which must start with
+ * '/'. Registering the same method and pattern again replaces the handler. Returns -1 for an unknown method,
+ * a malformed pattern, or a parameter named differently from one already registered at the same position. */
+int route_table_add(RouteTable *table, const char *method, const char *pattern, int handler);
+
+/* Looks up `path`, which must not include the query string. HEAD falls back to the GET handler. */
+RouteResult route_table_lookup(const RouteTable *table,
+                               const char *method,
+                               size_t method_len,
+                               const char *path,
+                               size_t path_len,
+                               RouteMatch *match);
+
+/* Writes the methods in `allowed` as an Allow header value ("GET, HEAD") and returns its length. */
+size_t route_allow_header(unsigned allowed, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROUTE_TABLE_H
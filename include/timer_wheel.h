@@ -0,0 +1,80 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Hierarchical timing wheel with millisecond ticks: TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots,
+ * each level TIMER_WHEEL_SLOTS times coarser than the one below it (64 ms, 4 s, 4.4 min, 4.7 h). Timers are
+ * intrusive, so inserting and cancelling are O(1) list operations without allocation; a timer on a coarse
+ * level is moved down a level whenever the wheel passes its slot.
+ *
+ * The wheel keeps no clock of its own. The owner advances it with the current monotonic time, and uses
+ * timer_wheel_next_expiry to arm a single OS timer (the event loop's timerfd) for all of them.
+ */
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct TimerEntry TimerEntry;
+
+typedef void (*TimerCallback)(TimerEntry *timer, void *ctx);
+
+struct TimerEntry {
+    TimerEntry *next;
+    TimerEntry *prev;
+    uint64_t expires_ms;
+    TimerCallback callback;
+};
+
+typedef struct {
+    uint64_t now_ms;
+    size_t count;
+    TimerEntry slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; /* List heads */
+    uint64_t occupied[TIMER_WHEEL_LEVELS];                   /* One bit per non-empty slot */
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t now_ms);
+
+/* Prepares a timer for use; it starts out not pending. */
+void timer_entry_init(TimerEntry *timer, TimerCallback callback);
+
+int timer_entry_pending(const TimerEntry *timer);
+
+/* (Re)schedules `timer` to fire at `expires_ms`; a time in the past fires on the next tick. */
+void timer_wheel_add(TimerWheel *wheel, TimerEntry *timer, uint64_t expires_ms);
+
+/* No-op for a timer that is not pending. */
+void timer_wheel_cancel(TimerWheel *wheel, TimerEntry *timer);
+
+/* Moves the wheel to `now_ms` and runs the callback of every timer that expired on the way, passing it `ctx`.
+ * Callbacks may add and cancel timers, including their own. Returns the number of callbacks run. */
+size_t timer_wheel_advance(TimerWheel *wheel, uint64_t now_ms, void *ctx);
+
+/* Earliest time at which advancing the wheel can have work to do (a timer expiring, or a coarse slot to move
+ * down), or UINT64_MAX when the wheel is empty. Never later than the first real expiry. */
+uint64_t timer_wheel_next_expiry(const TimerWheel *wheel);
+
+#endif // TIMER_WHEEL_H
@@ -35,11 +35,16 @@
 #include <time.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
 extern int server_fd_global;
 extern volatile sig_atomic_t server_running;
+/* Set by --debug-endpoints; the event-based server then serves the /debug/ profiling endpoints. */
+extern int debug_endpoints_enabled;
+/* Set in prefork mode: every worker binds the same port with SO_REUSEPORT. */
+extern int server_reuse_port;
 
 JSObject parse_url(const char* url_path);
 
@@ -55,10 +60,42 @@ void telemetry_increment_200_responses();
 
 int telemetry_get_200_responses();
 
+void telemetry_increment_timeouts();
+
+int telemetry_get_timeouts();
+
+int telemetry_share(int workers);
+
+void telemetry_select_worker(int index);
+
+int telemetry_get_worker_count();
+
 void telemetry_get_start_time(struct timespec* out);
 
+int telemetry_format_json(V8Engine* engine, char* buffer, size_t size);
+
 void start_server(V8Engine* engine);
 
+const char* http_status_text(int status);
+
+const char* http_find_header(const char* head, size_t head_len, const char* name, size_t* value_len);
+
+char* http_build_response_head(const JSResponse* response, int head_only, int keep_alive, size_t* out_len);
+
+int http_send_response_partial(int fd, const char* head, size_t head_len, JSSlice body, size_t* sent);
+
+int http_send_response(int fd, const char* head, size_t head_len, JSSlice body);
+
+int http_send_chunk(int fd, const char* data, size_t len);
+
+StaticFile* static_file_open(const char* path);
+
+void static_file_release(StaticFile* file);
+
+int http_send_file_partial(int fd, const char* head, size_t head_len, const StaticFile* file, size_t* sent);
+
+int http_send_file(int fd, const char* head, size_t head_len, const StaticFile* file);
+
 
 
 // ::: -------------------------:: Typedefs ::------------------------- ::: //
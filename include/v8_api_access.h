@@ -22,6 +22,9 @@
 #ifndef V8_WRAPPER_H
 #define V8_WRAPPER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,6 +58,121 @@ extern "C" {
         HTTPServerTypeEventLoop = 2
     } HTTPServerType;
 
+    /* Options passed as the optional third argument of ASP.create*Server(handler, port, options). */
+    typedef struct {
+        int isolate_per_worker; /* { isolatePerWorker: true } - thread pool only */
+        int reactors;           /* { reactors: N } - event loop only; 0 or 1 runs a single loop */
+        int accept_per_worker;  /* { acceptPerWorker: true } - thread pool only; one listener per worker */
+        int steer_to_cpu;       /* { steerToCpu: true } - with acceptPerWorker; pin workers, steer by CPU */
+        int js_executor;        /* { jsExecutor: true } - thread pool only; one thread runs all JS */
+        int keep_alive;         /* { keepAlive: true } - thread pool only; persistent connections */
+        int batch;              /* ASP.createBatchServer - most requests per handler call; 0: one at a time */
+    } ServerOptions;
+
+/* Largest request array handed to an ASP.createBatchServer handler in one call. */
+#define BATCH_SERVER_MAX 64
+
+    /* A borrowed (pointer, length) view into memory owned by someone else. Not NUL-terminated. */
+    typedef struct {
+        const char *ptr;
+        size_t len;
+    } JSSlice;
+
+    typedef struct {
+        JSSlice name;
+        JSSlice value;
+    } JSHeader;
+
+    /* Plain C request handed to v8_dispatch_request. A NULL body.ptr means "no body".
+     * Everything it points at must stay valid until the dispatch returns: the handler's body, headers
+     * and query are read from it on first access rather than copied up front.
+     * body_owner is the optional malloc'd block that body points into. For bodies of at least
+     * JS_EXTERNAL_BODY_MIN bytes the bridge takes it over instead of copying (and sets it to NULL);
+     * V8 frees it once the last string or ArrayBuffer referencing it is collected. */
+    typedef struct {
+        JSSlice method;
+        JSSlice path;
+        JSSlice body;
+        const JSHeader *headers;
+        int header_count;
+        char *body_owner;
+    } JSRequest;
+
+#define JS_EXTERNAL_BODY_MIN (16 * 1024)
+
+#define JS_RESPONSE_MAX_HEADERS 32
+
+    /* An open file from the static file cache (utils.c). */
+    typedef struct StaticFile StaticFile;
+
+    /* Filled by v8_dispatch_request; release with v8_free_response. Header slices point into `storage`.
+     * A string body is copied into `storage` as well. An ArrayBuffer / typed array body is not copied:
+     * `body` points straight into its backing store, which `body_hold` keeps alive until it is freed.
+     * A file body (ASP.static or { file: path }) is `file` instead, to be sent with http_send_file. */
+    typedef struct {
+        int status;
+        JSHeader headers[JS_RESPONSE_MAX_HEADERS];
+        int header_count;
+        JSSlice body;
+        int body_is_binary;
+        char *storage;
+        void *body_hold;
+        StaticFile *file;
+    } JSResponse;
+
+    typedef enum {
+        JS_DISPATCH_OK = 0,
+        JS_DISPATCH_NO_HANDLER,
+        JS_DISPATCH_EXCEPTION,
+        JS_DISPATCH_BAD_RESPONSE,
+        JS_DISPATCH_PENDING, /* Handler returned a Promise that has not settled yet */
+        JS_DISPATCH_TIMEOUT  /* Handler ran past V8EngineConfig.request_budget_ms and was terminated */
+    } JSDispatchResult;
+
+    /* A handler may return a Promise. Here it is settled before returning (one microtask checkpoint); a
+     * promise that still waits on something else is reported as JS_DISPATCH_BAD_RESPONSE. */
+    JSDispatchResult v8_dispatch_request(V8Engine *engine, JSRequest *request, JSResponse *response);
+
+    /* One entry of a v8_dispatch_batch call. */
+    typedef struct {
+        JSRequest *request;
+        JSResponse *response;
+        JSDispatchResult result;
+    } JSDispatchJob;
+
+    /* Runs `count` requests as v8_dispatch_request would, each with its own execution budget, but enters
+     * the isolate and context once for all of them. For an ASP.createBatchServer handler, the requests it
+     * serves go to it as one array in a single call. Same threading rule as v8_get_heap_stats. */
+    void v8_dispatch_batch(V8Engine *engine, JSDispatchJob *const *jobs, size_t count);
+
+    /* Called once when a parked handler promise settles, from inside v8_run_microtasks. `response` is only
+     * filled for JS_DISPATCH_OK; the callback owns it and must release it with v8_free_response. */
+    typedef void (*JSResponseCallback)(void *ctx, JSDispatchResult result, JSResponse *response);
+
+    /* Answers `request` from an ASP.static mount if it names a file there, without touching the isolate:
+     * callable from any thread, without the V8 lock. Returns 1 with `response` filled, or 0 (nothing to
+     * release) when the request has to go to v8_dispatch_request. */
+    int v8_serve_static(V8Engine *engine, JSRequest *request, JSResponse *response);
+
+    /* Like v8_dispatch_request, but a still-pending promise is parked instead: JS_DISPATCH_PENDING is
+     * returned, `*token` identifies the parked dispatch and `callback(ctx, ...)` runs when it settles. Any
+     * other result is final and `callback` is not called. A promise that never settles never calls back. */
+    JSDispatchResult v8_dispatch_request_async(V8Engine *engine,
+                                               JSRequest *request,
+                                               JSResponse *response,
+                                               JSResponseCallback callback,
+                                               void *ctx,
+                                               uint64_t *token);
+
+    /* Gives up on a parked dispatch: its callback will not run, so `ctx` may be freed right away. A token
+     * that already settled or was cancelled is ignored. Called on the engine's thread. */
+    void v8_cancel_dispatch(V8Engine *engine, uint64_t token);
+
+    /* Isolates run microtasks explicitly: event loops call this once per iteration. */
+    void v8_run_microtasks(V8Engine *engine);
+
+    void v8_free_response(JSResponse *response);
+
     const char *v8_get_string_property(V8Engine *engine, JSObject obj, const char *key);
 
     int v8_get_number_property(V8Engine *engine, JSObject obj, const char *key, int *success);
@@ -75,10 +193,34 @@ extern "C" {
 
     void v8_free_object(JSObject obj);
 
+    /* Heap sizing and GC tuning. Zero / NULL fields keep V8's defaults. Must be set before v8_initialize
+     * (or v8_initialize_from_snapshot); sizes apply to every isolate created afterwards. */
+    typedef struct {
+        size_t initial_heap_mb;
+        size_t max_heap_mb;     /* Overall budget, split between the generations by V8 */
+        size_t young_gen_mb;    /* Overrides the young generation part of max_heap_mb */
+        size_t old_gen_mb;      /* Overrides the old generation part of max_heap_mb */
+        const char *gc_profile; /* "low-latency", "throughput" or "small-footprint" */
+        const char *v8_flags;   /* Passed verbatim to v8::V8::SetFlagsFromString, after the profile */
+        size_t rss_pressure_mb; /* Process RSS above which v8_check_memory_pressure notifies V8; 0 = off */
+        size_t request_budget_ms; /* Wall time one dispatch (or timer callback) may run JS; 0 = unbounded */
+    } V8EngineConfig;
+
+    int v8_set_engine_config(const V8EngineConfig *config);
+
     V8Engine *v8_initialize(int argc, char *argv[]);
 
+    /* Startup snapshots: v8_build_snapshot runs `script` once and serializes the resulting heap to `path`;
+     * v8_initialize_from_snapshot boots from that file instead of compiling and running the script. */
+    int v8_build_snapshot(int argc, char *argv[], const char *script, const char *path);
+
+    V8Engine *v8_initialize_from_snapshot(int argc, char *argv[], const char *path);
+
     JSResult v8_execute_script(V8Engine *engine, const char *script);
 
+    /* Same, with a V8 code cache kept in "<script_path>.v8cache" (keyed by source hash and V8 version). */
+    JSResult v8_execute_script_cached(V8Engine *engine, const char *script, const char *script_path);
+
     int v8_register_function(V8Engine *engine, const char *name, int (*func)(int));
 
     void v8_cleanup(V8Engine *engine);
@@ -93,6 +235,74 @@ extern "C" {
 
     HTTPServerType v8_get_server_type(V8Engine *engine);
 
+    const ServerOptions *v8_get_server_options(V8Engine *engine);
+
+    V8Engine *v8_create_worker_engine(V8Engine *primary);
+
+    /* A copy of v8::HeapStatistics, in bytes. */
+    typedef struct {
+        size_t total_heap_size;
+        size_t total_physical_size;
+        size_t total_available_size;
+        size_t used_heap_size;
+        size_t heap_size_limit;
+        size_t malloced_memory;
+        size_t external_memory;
+    } JSHeapStats;
+
+    /* Main-thread GC pauses of one isolate, measured between the GC prologue and epilogue callbacks. */
+    typedef struct {
+        unsigned long long count;
+        unsigned long long total_pause_ns;
+        unsigned long long max_pause_ns;
+    } JSGcStats;
+
+    /* Must run on the thread that currently owns the isolate (e.g. inside invoke_with_v8_locker). */
+    int v8_get_heap_stats(V8Engine *engine, JSHeapStats *out);
+
+    /* Lock-free; may be called from any thread. */
+    void v8_get_gc_stats(V8Engine *engine, JSGcStats *out);
+
+    /* Gives V8 an idle slice of at most `idle_seconds`: runs the foreground tasks it has posted to the
+     * platform (incremental marking steps, scavenge jobs, finalizers), then its idle-time GC tasks.
+     * Returns 1 if any task ran. Same threading rule as v8_get_heap_stats. */
+    int v8_run_idle_tasks(V8Engine *engine, double idle_seconds);
+
+    typedef enum {
+        JS_MEMORY_PRESSURE_NONE,
+        JS_MEMORY_PRESSURE_MODERATE,
+        JS_MEMORY_PRESSURE_CRITICAL,
+    } JSMemoryPressure;
+
+    /* Compares the process RSS with V8EngineConfig.rss_pressure_mb (critical from 1.25x) and forwards
+     * level changes to Isolate::MemoryPressureNotification. Returns the current level. */
+    JSMemoryPressure v8_check_memory_pressure(V8Engine *engine);
+
+    /* Samples the engine's isolate with v8::CpuProfiler until v8_cpu_profile_stop. One profile at a time per
+     * engine: returns 0, or -1 if one is already running or it could not be started. */
+    int v8_cpu_profile_start(V8Engine *engine);
+
+    /* Stops the running profile and returns it as a malloc'd .cpuprofile JSON document (the format Chrome
+     * DevTools loads), or NULL if no profile was running. Same threading rule as v8_get_heap_stats. */
+    char *v8_cpu_profile_stop(V8Engine *engine, size_t *length);
+
+    /* Receives a serialized document piece by piece; return 0 to continue or -1 to abort the stream. */
+    typedef int (*JSChunkWriter)(void *ctx, const char *data, size_t len);
+
+    /* Takes a full heap snapshot and streams it as .heapsnapshot JSON through `write`. Blocks the calling
+     * thread for the duration. Returns 0, or -1 if it could not be taken or the writer aborted. */
+    int v8_heap_snapshot_write(V8Engine *engine, JSChunkWriter write, void *ctx);
+
+    /* Starts V8's sampling heap profiler (one allocation sampled per ~512 KiB on average). Returns 0, or -1
+     * if it is already running. */
+    int v8_heap_sampling_start(V8Engine *engine);
+
+    /* Stops the sampling heap profiler and streams the allocation profile as .heapprofile JSON through
+     * `write`. Returns 0, or -1 if none was running or the writer aborted. */
+    int v8_heap_sampling_stop(V8Engine *engine, JSChunkWriter write, void *ctx);
+
+    void v8_destroy_worker_engine(V8Engine *engine);
+
 #ifdef __cplusplus
 }
 
@@ -0,0 +1,56 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * Chase-Lev work-stealing deque of file descriptors, in the C11 formulation of Lê et al. (PPoPP 2013). The
+ * owning worker pushes and pops at the bottom (LIFO, so the connection it just served comes back first, with
+ * its buffers still in this core's cache); any other worker steals from the top (FIFO, the oldest entry).
+ * Owner operations only synchronize with thieves when a single entry is left.
+ *
+ * The capacity is fixed: a full deque refuses the push and the caller falls back to the shared ring.
+ */
+#define WORK_DEQUE_SIZE 64 /* Power of two */
+
+typedef struct {
+    alignas(64) _Atomic int64_t top;
+    alignas(64) _Atomic int64_t bottom;
+    _Atomic int slots[WORK_DEQUE_SIZE];
+} WorkDeque;
+
+void work_deque_init(WorkDeque *deque);
+
+/* Owner only. 0 on success, -1 when the deque is full. */
+int work_deque_push(WorkDeque *deque, int fd);
+
+/* Owner only. The most recently pushed fd, or -1 when empty. */
+int work_deque_pop(WorkDeque *deque);
+
+/* Any thread. The oldest fd, or -1 when empty or when another thief won the race for it. */
+int work_deque_steal(WorkDeque *deque);
+
+#endif // WORK_DEQUE_H
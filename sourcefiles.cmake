@@ -3,8 +3,18 @@ set(SOURCE_FILES
         src/m1_2__simple_server.c
         src/m3__multi_threaded_server.c
         src/m4_5__event_based_server.c
+        src/timer_wheel.c
+        src/route_table.c
+        src/conn_ring.c
+        src/work_deque.c
+        src/js_executor.c
         src/utils.c
         include/utils.h
         include/m3__multi_threaded_server.h
         include/m4_5__event_based_server.h
+        include/timer_wheel.h
+        include/route_table.h
+        include/conn_ring.h
+        include/work_deque.h
+        include/js_executor.h
 )
\ No newline at end of file
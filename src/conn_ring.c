@@ -0,0 +1,210 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "conn_ring.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Rounds of exponentially growing pause loops (1, 2, 4, ... pauses) before a consumer parks. */
+#define CONN_RING_SPIN_ROUNDS 8
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static void futex_wait(_Atomic uint32_t *word, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word, int count) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Slot i starts with sequence i: free for the producer that *
+  * claims position i. A push sets it to pos + 1 (full for    *
+  * the consumer of pos), a pop to pos + capacity (free for   *
+  * the producer one lap later).                              *
+  *************************************************************
+*/
+int conn_ring_init(ConnRing *ring, size_t capacity) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        return -1;
+    ring->slots = calloc(capacity, sizeof(ConnRingSlot));
+    if (!ring->slots)
+        return -1;
+    for (size_t i = 0; i < capacity; ++i) {
+        atomic_init(&ring->slots[i].seq, i);
+        ring->slots[i].fd = -1;
+    }
+    ring->mask = capacity - 1;
+    ring->spin_rounds = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? CONN_RING_SPIN_ROUNDS : 0;
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+    atomic_init(&ring->wake_seq, 0);
+    atomic_init(&ring->waiters, 0);
+    atomic_init(&ring->closed, 0);
+    return 0;
+}
+
+void conn_ring_destroy(ConnRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int conn_ring_try_push(ConnRing *ring, int fd) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    ConnRingSlot *slot;
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return -1; /* The consumer of the previous lap has not taken this slot yet */
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    slot->fd = fd;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    conn_ring_notify(ring);
+    return 0;
+}
+
+int conn_ring_push(ConnRing *ring, int fd) {
+    while (conn_ring_try_push(ring, fd) != 0) {
+        if (atomic_load_explicit(&ring->closed, memory_order_acquire))
+            return -1;
+        sched_yield();
+    }
+    return 0;
+}
+
+int conn_ring_try_pop(ConnRing *ring) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    ConnRingSlot *slot;
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return -1; /* Not pushed yet: empty */
+        } else {
+            pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    int fd = slot->fd;
+    atomic_store_explicit(&slot->seq, pos + ring->mask + 1, memory_order_release);
+    return fd;
+}
+
+static int conn_ring_empty(ConnRing *ring) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        size_t seq = atomic_load_explicit(&ring->slots[pos & ring->mask].seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0)
+            return 0;
+        if (diff < 0)
+            return 1;
+        pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed); /* Raced with a pop */
+    }
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Spins with growing pauses first (on SMP), since under     *
+  * load the next connection usually arrives within           *
+  * microseconds, then parks on the wake_seq futex. Reading   *
+  * wake_seq before registering as a waiter means a push or   *
+  * notify that lands in between makes FUTEX_WAIT return at   *
+  * once.                                                     *
+  *************************************************************
+*/
+int conn_ring_wait(ConnRing *ring) {
+    for (int round = 0; round < ring->spin_rounds; ++round) {
+        if (!conn_ring_empty(ring))
+            return 0;
+        for (int i = 0; i < (1 << round); ++i)
+            cpu_relax();
+    }
+    uint32_t seen = atomic_load_explicit(&ring->wake_seq, memory_order_acquire);
+    atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+    int empty = conn_ring_empty(ring);
+    if (empty && !closed)
+        futex_wait(&ring->wake_seq, seen);
+    atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_relaxed);
+    return closed && empty ? -1 : 0;
+}
+
+void conn_ring_notify(ConnRing *ring) {
+    // ::: Pairs with the fence in conn_ring_wait: either a parking consumer sees the new work, or we see it
+    // --- counted in `waiters` and wake it. With nobody parked, this costs no system call.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add_explicit(&ring->wake_seq, 1, memory_order_release);
+        futex_wake(&ring->wake_seq, 1);
+    }
+}
+
+void conn_ring_close(ConnRing *ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+    atomic_fetch_add_explicit(&ring->wake_seq, 1, memory_order_release);
+    futex_wake(&ring->wake_seq, INT_MAX);
+}
@@ -0,0 +1,187 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "js_executor.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define JOB_PENDING 0
+#define JOB_DONE 1
+#define JOB_WAITING 2 /* Pending, and the submitter is asleep on the futex */
+
+#define EXECUTOR_BATCH 64
+#define SPIN_ITERATIONS 256
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static void futex_wait(_Atomic uint32_t *word, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+typedef struct {
+    V8Engine *engine;
+    JSDispatchJob *jobs[EXECUTOR_BATCH];
+    size_t count;
+} Batch;
+
+static int run_batch(void *data) {
+    Batch *batch = (Batch *)data;
+    v8_dispatch_batch(batch->engine, batch->jobs, batch->count);
+    return 0;
+}
+
+static void complete(JsExecutorJob *job) {
+    if (atomic_exchange_explicit(&job->state, JOB_DONE, memory_order_acq_rel) == JOB_WAITING)
+        futex_wake(&job->state);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Runs batches of up to EXECUTOR_BATCH jobs, each under one *
+  * v8::Locker, for as long as there are submissions. Job     *
+  * fields are read before `next` can be reused: a completed  *
+  * job belongs to its submitter again.                       *
+  *************************************************************
+*/
+static void *executor_thread(void *arg) {
+    JsExecutor *executor = (JsExecutor *)arg;
+    Batch batch = { .engine = executor->engine };
+    for (;;) {
+        JsExecutorJob *stack = atomic_exchange_explicit(&executor->submitted, NULL, memory_order_acquire);
+        if (!stack) {
+            for (int i = 0; i < executor->spin_iterations; ++i) {
+                if (atomic_load_explicit(&executor->submitted, memory_order_relaxed)) break;
+                cpu_relax();
+            }
+            if (atomic_load_explicit(&executor->submitted, memory_order_relaxed)) continue;
+            // ::: Pairs with the fence in js_executor_dispatch: either we see its job, or it sees us asleep.
+            atomic_store_explicit(&executor->sleeping, 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            int stopping = atomic_load_explicit(&executor->stopping, memory_order_acquire);
+            if (!atomic_load_explicit(&executor->submitted, memory_order_relaxed) && !stopping)
+                futex_wait(&executor->sleeping, 1);
+            atomic_store_explicit(&executor->sleeping, 0, memory_order_relaxed);
+            if (stopping && !atomic_load_explicit(&executor->submitted, memory_order_acquire)) break;
+            continue;
+        }
+
+        // ::: The stack is newest first; reverse it so requests run in the order they arrived.
+        JsExecutorJob *queue = NULL;
+        while (stack) {
+            JsExecutorJob *next = stack->next;
+            stack->next = queue;
+            queue = stack;
+            stack = next;
+        }
+        while (queue) {
+            JsExecutorJob *jobs[EXECUTOR_BATCH];
+            batch.count = 0;
+            while (queue && batch.count < EXECUTOR_BATCH) {
+                jobs[batch.count] = queue;
+                batch.jobs[batch.count++] = &queue->dispatch;
+                queue = queue->next;
+            }
+            invoke_with_v8_locker(executor->engine, run_batch, &batch);
+            for (size_t i = 0; i < batch.count; ++i)
+                complete(jobs[i]);
+        }
+    }
+    return NULL;
+}
+
+int js_executor_start(JsExecutor *executor, V8Engine *engine) {
+    executor->engine = engine;
+    executor->spin_iterations = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_ITERATIONS : 0;
+    atomic_init(&executor->submitted, NULL);
+    atomic_init(&executor->sleeping, 0);
+    atomic_init(&executor->stopping, 0);
+    return pthread_create(&executor->thread, NULL, executor_thread, executor) == 0 ? 0 : -1;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Pushes a job that lives on the caller's stack and waits   *
+  * for it: a short spin first, since a batch usually takes   *
+  * microseconds, then FUTEX_WAIT once the job is marked      *
+  * JOB_WAITING so the executor knows to wake us.             *
+  *************************************************************
+*/
+JSDispatchResult js_executor_dispatch(JsExecutor *executor, JSRequest *request, JSResponse *response) {
+    JsExecutorJob job = { .dispatch = { .request = request, .response = response } };
+    atomic_init(&job.state, JOB_PENDING);
+    JsExecutorJob *head = atomic_load_explicit(&executor->submitted, memory_order_relaxed);
+    do {
+        job.next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&executor->submitted, &head, &job,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&executor->sleeping, memory_order_relaxed)) {
+        atomic_store_explicit(&executor->sleeping, 0, memory_order_relaxed);
+        futex_wake(&executor->sleeping);
+    }
+
+    for (int i = 0; i < executor->spin_iterations; ++i) {
+        if (atomic_load_explicit(&job.state, memory_order_acquire) == JOB_DONE) return job.dispatch.result;
+        cpu_relax();
+    }
+    uint32_t expected = JOB_PENDING;
+    if (atomic_compare_exchange_strong_explicit(&job.state, &expected, JOB_WAITING,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        while (atomic_load_explicit(&job.state, memory_order_acquire) != JOB_DONE)
+            futex_wait(&job.state, JOB_WAITING);
+    }
+    return job.dispatch.result;
+}
+
+void js_executor_stop(JsExecutor *executor) {
+    atomic_store_explicit(&executor->stopping, 1, memory_order_release);
+    atomic_store_explicit(&executor->sleeping, 0, memory_order_relaxed);
+    futex_wake(&executor->sleeping);
+    pthread_join(executor->thread, NULL);
+}
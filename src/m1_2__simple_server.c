@@ -91,6 +91,12 @@ static int create_and_bind_socket(int port)
       perror("Failed to set sockOpt for SO_REUSEADDR");
       goto CLEANUP_SOCKET_ON_ERROR;
    }
+   // ::: Prefork workers all bind the same port; the kernel spreads incoming connections over them.
+   if (server_reuse_port &&
+       setsockopt(serverSocketFd, SOL_SOCKET, SO_REUSEPORT, (const void*)&enabled, sizeof(enabled)) == -1) {
+      perror("Failed to set sockOpt for SO_REUSEPORT");
+      goto CLEANUP_SOCKET_ON_ERROR;
+   }
 
    // ::: Building the address struct
    struct sockaddr_in serverAddress = {
@@ -19,9 +19,15 @@
 * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+// ::: strcasestr, pthread_setaffinity_np
+#define _GNU_SOURCE
+
 #include "m3__multi_threaded_server.h"
 
+#include "conn_ring.h"
+#include "js_executor.h"
 #include "utils.h"
+#include "work_deque.h"
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,39 +39,84 @@
 #include <stdint.h>
 #include <time.h>
 #include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <linux/filter.h>
 
-#define MAX_QUEUE 128
+#define MAX_QUEUE 128   // ::: Must be a power of two (conn_ring_init).
 #define DEFAULT_THREADS 4
 #define MAX_THREADS 64
 #define BUFFER_SIZE 1024
+#define REQUEST_TIMEOUT_SEC 5
+#define MAX_REQUEST_SIZE (64 * 1024 * 1024)
+// ::: With { keepAlive: true }: how long a worker waits for the next request on a connection before closing
+// --- it. Short, since the worker is pinned meanwhile; HTTP/1.1 lets the server close an idle connection at
+// --- any time.
+#define KEEP_ALIVE_IDLE_MS 100
+// ::: Back-to-back requests a worker serves on one connection before handing it to the shared ring, so the
+// --- connections waiting in its deque get a turn.
+#define KEEP_ALIVE_BURST 16
+// ::: Connections a worker takes from the shared ring at once; the extra ones can be stolen.
+#define RING_BATCH 4
 
 typedef struct {
     char *method;
-    char *body;
+    char *path;
+    char *body;     // ::: Points into the raw request buffer, not NUL-terminated at `size`.
     size_t size;
+    char *raw;      // ::: The malloc'd read buffer; NULL once V8 has adopted it for a large body.
+    int keep_alive;
 } MtHttpRequest;
 
+// ::: Bytes read past the end of one request on a connection: the start of the next one (pipelining).
+typedef struct {
+    char *data;
+    size_t len;
+} PendingBytes;
+
 typedef struct ThreadPool {
-    int conn_queue[MAX_QUEUE];
-    int queue_head, queue_tail, queue_size;
-    pthread_mutex_t queue_mutex;
-    pthread_cond_t queue_cond;
+    ConnRing conn_queue;
+    WorkDeque deques[MAX_THREADS];  // ::: One per worker: its keep-alive follow-ups and batch extras.
     pthread_t threads[MAX_THREADS];
     int num_threads;
     volatile sig_atomic_t running;
     int server_fd;
+    // ::: Only used with { acceptPerWorker: true }: worker i accepts on listen_fds[i], -1 otherwise.
+    int listen_fds[MAX_THREADS];
+    int steer_to_cpu;  // ::: Workers are pinned to CPU `index` and the listeners steer by receiving CPU.
+    JsExecutor executor;
+    // ::: Only used with { isolatePerWorker: true }: one private isolate per worker, NULL otherwise.
+    V8Engine *worker_engines[MAX_THREADS];
 } ThreadPool;
 
 typedef struct WorkerArgs {
     V8Engine *engine;
     struct ThreadPool *pool;
+    int index;
 } WorkerArgs;
 
+static void destroy_thread_pool(ThreadPool *pool);
+
+// ::: Set while opening { acceptPerWorker: true } listeners, which share the port like prefork workers do.
+static int per_worker_listeners = 0;
+
+// ::: With { jsExecutor: true }: the thread that runs every handler call, NULL otherwise.
+static JsExecutor *js_executor = NULL;
+
+// ::: { keepAlive: true }. Off by default: a worker waiting on an idle connection serves nothing else, so
+// --- every response says Connection: close unless the app asks for persistent connections.
+static int keep_alive_connections = 0;
+
 struct WorkerRequestData {
     V8Engine *engine;
+    MtHttpRequest request;
     char *buffer;
-    char *response_buffer;
+    char *response_buffer;  // ::: Status line and headers only; the body stays in `response`.
     size_t response_size;
+    size_t buffer_len;
+    int keep_alive;
+    JSResponse response;
 };
 
 /**
@@ -77,26 +128,14 @@ struct WorkerRequestData {
  *  |_|  |_| M3
  *
  * Adds a connection file descriptor to the thread pool's connection queue.
- * If the queue is full, the function waits until space is available.
+ * If the queue is full, the function yields until space is available.
  *
- * Useful APIs and system calls:
- *   - pthread_mutex_lock()   : Lock a mutex for exclusive access.
- *   - pthread_cond_wait()    : Wait for a condition variable to be signaled.
- *   - pthread_mutex_unlock() : Unlock a mutex.
- *   - pthread_cond_signal()  : Signal a condition variable.
+ * The queue is a lock-free ring (conn_ring.h): the acceptor and the workers never contend on a
+ * mutex, and a hand-off only costs a futex wake when a worker has actually gone to sleep.
  */
 static void enqueue_conn(ThreadPool *pool, int connfd) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    if (!pool->running || conn_ring_push(&pool->conn_queue, connfd) != 0)
+        close(connfd);
 }
 
 /**
@@ -107,27 +146,40 @@ static void enqueue_conn(ThreadPool *pool, int connfd) {
  *  | |  | |
  *  |_|  |_| M3
  *
- * Removes and returns a connection file descriptor from the thread pool's connection queue.
- * If the queue is empty, the function waits until a connection is available or the server is stopped.
+ * Returns the next connection for worker `self` to serve, or -1 once the server is stopping.
  *
- * Useful APIs and system calls:
- *   - pthread_mutex_lock()   : Locks a mutex for exclusive access.
- *   - pthread_cond_wait()    : Wait for a condition variable to be signaled.
- *   - pthread_mutex_unlock() : Unlock a mutex.
- *   - pthread_cond_signal()  : Signal a condition variable.
+ * Work is looked for close to home first: the worker's own deque (the connection it just served, whose
+ * buffers are still in this core's cache), then a batch from the shared ring, then the oldest entry of
+ * another worker's deque. Only when all of them are empty does the worker spin and park on the ring.
  */
-static int dequeue_conn(ThreadPool *pool) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static int steal_conn(ThreadPool *pool, int self) {
+    for (int i = 1; i < pool->num_threads; ++i) {
+        int connfd = work_deque_steal(&pool->deques[(self + i) % pool->num_threads]);
+        if (connfd >= 0) return connfd;
+    }
+    return -1;
+}
+
+static int dequeue_conn(ThreadPool *pool, int self) {
+    WorkDeque *local = &pool->deques[self];
+    for (;;) {
+        int connfd = work_deque_pop(local);
+        if (connfd >= 0) return connfd;
+        connfd = conn_ring_try_pop(&pool->conn_queue);
+        if (connfd >= 0) {
+            // ::: The deque is empty here, so the batch always fits; parked workers are woken to steal it.
+            int extra, taken = 0;
+            while (taken < RING_BATCH - 1 && (extra = conn_ring_try_pop(&pool->conn_queue)) >= 0) {
+                work_deque_push(local, extra);
+                taken++;
+            }
+            if (taken) conn_ring_notify(&pool->conn_queue);
+            return connfd;
+        }
+        connfd = steal_conn(pool, self);
+        if (connfd >= 0) return connfd;
+        if (conn_ring_wait(&pool->conn_queue) != 0) return -1;
+    }
 }
 
 /**
@@ -151,18 +203,41 @@ static int dequeue_conn(ThreadPool *pool) {
  *   - Memory management: memset(), malloc(), free()
  *   - String manipulation and parsing: sscanf(), strstr(), strncpy(), strlen(), strtol()
  */
-void parse_http_request_url(V8Engine *engine, const char *raw_request, MtHttpRequest *request) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+void parse_http_request_url(V8Engine *engine, const char *raw_request, size_t raw_len,
+                            MtHttpRequest *request) {
+    memset(request, 0, sizeof(*request));
+    char method[16] = { 0 };
+    char path[2048] = { 0 };
+    char version[16] = { 0 };
+    if (sscanf(raw_request, "%15s %2047s %15s", method, path, version) < 1) return;
+    request->method = strdup(method);
+    request->path = path[0] ? strdup(path) : NULL;
+
+    const char *header_end = strstr(raw_request, "\r\n\r\n");
+    if (!header_end) return;
+    // ::: HTTP/1.1 connections persist unless the client says close; HTTP/1.0 ones only when asked to.
+    size_t connection_len = 0;
+    const char *connection = http_find_header(raw_request, header_end - raw_request, "Connection",
+                                              &connection_len);
+    char value[64] = { 0 };
+    if (connection) snprintf(value, sizeof(value), "%.*s", (int)connection_len, connection);
+    request->keep_alive = keep_alive_connections && (strcmp(version, "HTTP/1.1") == 0
+                                                         ? !strcasestr(value, "close")
+                                                         : strcasestr(value, "keep-alive") != NULL);
+    const char *body = header_end + 4;
+    size_t available = raw_len - (body - raw_request);
+    size_t length = available;
+    const char *content_length =
+        http_find_header(raw_request, header_end - raw_request, "Content-Length", NULL);
+    if (content_length) {
+        long parsed = strtol(content_length, NULL, 10);
+        if (parsed >= 0 && (size_t)parsed < available) length = (size_t)parsed;
+    }
+    if (length > 0) {
+        // ::: The body is left in the request buffer, which outlives the request.
+        request->body = (char *)body;
+        request->size = length;
+    }
 }
 
 /*
@@ -175,34 +250,44 @@ void parse_http_request_url(V8Engine *engine, const char *raw_request, MtHttpReq
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
-  * Creates a JS object for a given request                   *
+  * Describes a parsed request for v8_dispatch_request        *
   *************************************************************
 */
-JSObject create_js_request_object(V8Engine *engine, const MtHttpRequest *request) {
-    JSObject req_obj = v8_create_object(engine);
-    if (!req_obj) {
-        return NULL;
-    }
-    if (!v8_set_string_property(engine, req_obj, "method", request->method)) {
-        v8_free_object(req_obj);
-        return NULL;
-    }
-    if (request->body) {
-        if (!v8_set_string_property(engine, req_obj, "body", request->body)) {
-            v8_free_object(req_obj);
-            return NULL;
-        }
-        if (!v8_set_number_property(engine, req_obj, "size", request->size)) {
-            v8_free_object(req_obj);
-            return NULL;
-        }
-    } else {
-        if (!v8_set_number_property(engine, req_obj, "size", 0)) {
-            v8_free_object(req_obj);
-            return NULL;
-        }
+static JSRequest to_js_request(const MtHttpRequest *request) {
+    JSRequest js_request = {
+        .method = { request->method, strlen(request->method) },
+        .path = { request->path, request->path ? strlen(request->path) : 0 },
+        .body = { request->body, request->size },
+        .headers = NULL,
+        .header_count = 0,
+        .body_owner = request->raw,
+    };
+    return js_request;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Serializes the head of a filled response. For HEAD the    *
+  * body is dropped here, so it is never sent.                *
+  *************************************************************
+*/
+static void build_response_head_mt(const MtHttpRequest *request, JSResponse *response, char **response_buffer,
+                                   size_t *response_size) {
+    int head_only = strcmp(request->method, "HEAD") == 0;
+    *response_buffer = http_build_response_head(response, head_only, request->keep_alive, response_size);
+    if (head_only) {
+        response->body = (JSSlice){ NULL, 0 };
+        static_file_release(response->file);
+        response->file = NULL;
     }
-    return req_obj;
 }
 
 /**
@@ -217,45 +302,40 @@ JSObject create_js_request_object(V8Engine *engine, const MtHttpRequest *request
  * This function bridges the C server and the JavaScript handler, using the V8 engine to process the request
  * and generate a response object, which is then serialized into a proper HTTP response string.
  *
- * Note: This method uses functions from `v8_api_utils` such as `create_js_request_object` to read the response data from JavaScript.
- *
- * Implementation hints:
- *   1. Create a JavaScript request object from the parsed HTTP request using `create_js_request_object`.
- *   2. Call the registered JavaScript handler with the request object.
- *   3. Check if the handler call was successful and returned an object.
- *       a. Extract the HTTP status code from the response object.
- *       b. Extract the Content-Type from the response headers.
- *       c. Extract the response body from the response object.
- *  4. Format the HTTP response string with status, headers, and body:
- *       a. Make sure the HTTP response is well-formed (e.g., map status codes to reason phrases).
- *       b. Include necessary headers like Content-Length, Date, Server, and Connection.
- *       c. Handle special cases like HEAD requests (no body).
- *       d. Provide default error bodies for common status codes (e.g., 404, 500).
- *       e. The server name should be 'asp-v8/1.0'
+ * The whole JS round trip is a single v8_dispatch_request call (made on the JS executor thread when there
+ * is one): it builds the request object, calls the
+ * handler and copies { status, headers, body } back out under one set of V8 scopes.
+ * http_build_response_head (utils.c) then adds Content-Length, Date, Server and Connection, maps the status
+ * to a reason phrase and fills in default error bodies. The body itself is left in `response` (for
+ * ArrayBuffer bodies that is V8's own backing store) and written next to the head by create_response.
  *
  * Useful APIs and system calls used:
- *   - create_js_request_object()         : Converts the C request to a JS object (from v8_api_utils).
- *   - v8_get_registered_handler_func()   : Gets the registered JS handler.
- *   - v8_call_registered_handler_obj()   : Calls the JS handler with the request object.
- *   - v8_free_object()                   : Frees JS objects handles.
- *   - v8_get_number_property()           : Reads a numeric property from a JS object.
- *   - v8_has_property()                  : Checks if a JS object has a property.
- *   - v8_get_object_property()           : Gets an object property from a JS object.
- *   - v8_get_string_property()           : Gets a string property from a JS object.
- *   - snprintf(), strdup()               : String manipulation.
+ *   - v8_dispatch_request()              : Runs the request through the registered handler.
+ *   - http_build_response_head()         : Serializes the status line and headers.
  */
-void handle_request_url(V8Engine *engine, const MtHttpRequest *request, char **response_buffer, size_t *response_size) {
-    /**
-    ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-    ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-    ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-    ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-    ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-    ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-    ━━━━━━━━━━━━━━━━━━━━━
-    ━━━ Your code here...
-    ━━━━━━━━━━━━━━━━━━━━━
-    */
+void handle_request_url(V8Engine *engine, MtHttpRequest *request, JSResponse *response,
+                        char **response_buffer, size_t *response_size) {
+    *response_buffer = NULL;
+    *response_size = 0;
+    memset(response, 0, sizeof(*response));
+    if (!request->method) return;
+
+    JSRequest js_request = to_js_request(request);
+    JSDispatchResult result = js_executor ? js_executor_dispatch(js_executor, &js_request, response)
+                                          : v8_dispatch_request(engine, &js_request, response);
+    request->raw = js_request.body_owner;
+    if (result == JS_DISPATCH_TIMEOUT) {
+        // ::: The watchdog cut the handler off, so the isolate is free again; the client gets a 503.
+        telemetry_increment_timeouts();
+        response->status = 503;
+    } else if (result != JS_DISPATCH_OK) {
+        if (result == JS_DISPATCH_NO_HANDLER)
+            fprintf(stderr,
+                    "No JS handler registered. Did you call ASP.createThreadPoolServer in your script?\n");
+        // ::: Leaving the buffer NULL makes create_response answer with a 500.
+        return;
+    }
+    build_response_head_mt(request, response, response_buffer, response_size);
 }
 
 /*
@@ -273,13 +353,19 @@ void handle_request_url(V8Engine *engine, const MtHttpRequest *request, char **r
 */
 int process_request(void *data) {
     struct WorkerRequestData *d = (struct WorkerRequestData *)data;
-    V8Engine *engine = d->engine;
-    MtHttpRequest request;
-    parse_http_request_url(engine, d->buffer, &request);
-    handle_request_url(engine, &request, &d->response_buffer, &d->response_size);
+    handle_request_url(d->engine, &d->request, &d->response, &d->response_buffer, &d->response_size);
     return 0;
 }
 
+// ::: A cached static file needs no JS, so it is answered before the V8 lock (or the executor) is involved.
+static int serve_static_request(struct WorkerRequestData *d) {
+    if (!d->request.method) return 0;
+    JSRequest js_request = to_js_request(&d->request);
+    if (!v8_serve_static(d->engine, &js_request, &d->response)) return 0;
+    build_response_head_mt(&d->request, &d->response, &d->response_buffer, &d->response_size);
+    return 1;
+}
+
 /**
  *   __  __
  *  |  \/  |
@@ -307,18 +393,41 @@ int process_request(void *data) {
  *   On failure: -1.
  */
 int create_and_bind_socket_mt(int port) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return 0;
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int enabled = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled)) < 0) {
+        perror("setsockopt(SO_REUSEADDR)");
+        close(server_fd);
+        return -1;
+    }
+    // ::: Prefork workers and per-worker listeners all bind the same port; the kernel spreads incoming
+    // --- connections over them.
+    if ((server_reuse_port || per_worker_listeners) &&
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) < 0) {
+        perror("setsockopt(SO_REUSEPORT)");
+        close(server_fd);
+        return -1;
+    }
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons((u16)port),
+    };
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("bind");
+        close(server_fd);
+        return -1;
+    }
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        perror("listen");
+        close(server_fd);
+        return -1;
+    }
+    return server_fd;
 }
 
 /**
@@ -347,22 +456,77 @@ int create_and_bind_socket_mt(int port) {
  *   - Socket: read()
  *   - Strings: strstr(), strlen(), strcpy(), strncpy()
  *
+ * Reading starts from the bytes `carry` holds from the previous request on the connection. Anything read
+ * past the end of this request is left in `carry` for the next one.
+ *
  * Returns:
  *   On success: pointer to the buffer containing the request (must be freed by caller).
  *   On failure: NULL.
  */
-char *read_full_request(int connfd, size_t *out_len) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+char *read_full_request(int connfd, size_t *out_len, PendingBytes *carry) {
+    // ::: Don't let a slow or stuck client pin a worker forever.
+    struct timeval timeout = { .tv_sec = REQUEST_TIMEOUT_SEC, .tv_usec = 0 };
+    setsockopt(connfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    size_t capacity = carry->len > BUFFER_SIZE ? carry->len : BUFFER_SIZE;
+    size_t len = 0;
+    size_t header_len = 0;
+    size_t expected = 0;
+    size_t scan_from = 0;
+    char *buffer = malloc(capacity + NULL_TERMINATOR_SIZE);
+    if (!buffer) return NULL;
+    if (carry->len) memcpy(buffer, carry->data, carry->len);
+    len = carry->len;
+    buffer[len] = '\0';
+    free(carry->data);
+    *carry = (PendingBytes){ NULL, 0 };
+
+    for (;;) {
+        if (!header_len) {
+            char *end = strstr(buffer + scan_from, "\r\n\r\n");
+            if (end) {
+                header_len = (size_t)(end + 4 - buffer);
+                const char *content_length = http_find_header(buffer, header_len, "Content-Length", NULL);
+                long body_len = content_length ? strtol(content_length, NULL, 10) : 0;
+                if (body_len < 0 || body_len > MAX_REQUEST_SIZE) goto FAIL;
+                expected = header_len + (size_t)body_len;
+            } else {
+                scan_from = len > 3 ? len - 3 : 0;
+            }
+        }
+        if (header_len && len >= expected) break;
+        if (len == capacity) {
+            // ::: Once Content-Length is known, grow straight to the final size instead of doubling.
+            size_t new_capacity = (header_len && expected > capacity) ? expected : capacity * 2;
+            char *grown = realloc(buffer, new_capacity + NULL_TERMINATOR_SIZE);
+            if (!grown) goto FAIL;
+            buffer = grown;
+            capacity = new_capacity;
+        }
+        ssize_t n = read(connfd, buffer + len, capacity - len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            goto FAIL;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+        buffer[len] = '\0';
+    }
+    if (!header_len) goto FAIL;
+    if (len > expected) {
+        // ::: A pipelining client already sent (part of) its next request; keep it for that one.
+        carry->data = malloc(len - expected);
+        if (!carry->data) goto FAIL;
+        memcpy(carry->data, buffer + expected, len - expected);
+        carry->len = len - expected;
+        len = expected;
+        buffer[len] = '\0';
+    }
+    *out_len = len;
+    return buffer;
+
+FAIL:
+    free(buffer);
     return NULL;
 }
 
@@ -385,18 +549,49 @@ char *read_full_request(int connfd, size_t *out_len) {
  *   - Memory management: free()
  *   - Strings: strlen(), strcpy(), strcat()
  */
-void create_response(int connfd, char *req_buf, struct WorkerRequestData d) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int create_response(int connfd, char *req_buf, struct WorkerRequestData d) {
+    static const char internal_error[] = "HTTP/1.1 500 Internal Server Error\r\n"
+                                         "Content-Type: text/plain\r\n"
+                                         "Content-Length: 21\r\n"
+                                         "Server: asp-v8/1.0\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n"
+                                         "Internal Server Error";
+    telemetry_increment_request_count();
+    if (d.response_buffer && d.response.status == 200) telemetry_increment_200_responses();
+    int sent;
+    if (d.response_buffer && d.response.file) {
+        sent = http_send_file(connfd, d.response_buffer, d.response_size, d.response.file);
+    } else if (d.response_buffer) {
+        sent = http_send_response(connfd, d.response_buffer, d.response_size, d.response.body);
+    } else {
+        sent = write_all(connfd, internal_error, sizeof(internal_error) - 1);
+    }
+    free(d.response_buffer);
+    // ::: Releasing an ArrayBuffer body's backing store is safe without the V8 lock.
+    v8_free_response(&d.response);
+    free(req_buf);
+    return sent;
+}
+
+// ::: Closes a connection along with any pipelined bytes read from it.
+static void close_conn(int connfd, PendingBytes *carry) {
+    free(carry->data);
+    *carry = (PendingBytes){ NULL, 0 };
+    close(connfd);
 }
 
 /*
@@ -409,16 +604,59 @@ void create_response(int connfd, char *req_buf, struct WorkerRequestData d) {
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
-  * Handle a new connection                                   *
+  * Serves one request; returns 1 if the connection is kept   *
+  * open for the next one, 0 once it is closed. `carry` holds *
+  * the connection's unread pipelined bytes; while it is not  *
+  * empty, the next request must be served on this thread.    *
   *************************************************************
 */
-void handle_connection_mt(V8Engine *engine, int connfd) {
+int handle_connection_mt(V8Engine *engine, int connfd, PendingBytes *carry) {
     size_t req_len = 0;
-    char *req_buf = read_full_request(connfd, &req_len);
-    if (!req_buf) { close(connfd); return; }
-    struct WorkerRequestData d = { engine, req_buf, NULL, 0 };
-    process_request(&d);
-    create_response(connfd, req_buf, d);
+    char *req_buf = read_full_request(connfd, &req_len, carry);
+    if (!req_buf) { close_conn(connfd, carry); return 0; }
+    struct WorkerRequestData d = { .engine = engine, .buffer = req_buf, .buffer_len = req_len };
+    parse_http_request_url(engine, d.buffer, d.buffer_len, &d.request);
+    d.request.raw = d.buffer;
+    // ::: With a shared isolate this serializes the workers; with isolatePerWorker the lock is uncontended.
+    // --- With jsExecutor the worker never takes it: parsing and serialization stay here, JS runs there.
+    if (!serve_static_request(&d)) {
+        if (js_executor)
+            process_request(&d);
+        else
+            invoke_with_v8_locker(engine, process_request, &d);
+    }
+    d.keep_alive = d.request.keep_alive;
+    // ::: Large bodies are handed to V8 as-is; the buffer is then freed by the GC, not by create_response.
+    d.buffer = d.request.raw;
+    free(d.request.method);
+    free(d.request.path);
+    // ::: The 500 fallback says Connection: close, so only a real response keeps the connection.
+    int keep_alive = d.keep_alive && d.response_buffer;
+    if (create_response(connfd, d.buffer, d) != 0) keep_alive = 0;
+    if (!keep_alive) close_conn(connfd, carry);
+    return keep_alive;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Waits up to KEEP_ALIVE_IDLE_MS for the next request on a  *
+  * kept-alive connection. Returns 1 when it has arrived, or  *
+  * closes the connection and returns 0.                      *
+  *************************************************************
+*/
+static int await_next_request(int connfd) {
+    struct pollfd pfd = { .fd = connfd, .events = POLLIN };
+    if (poll(&pfd, 1, KEEP_ALIVE_IDLE_MS) > 0) return 1;
+    close(connfd);
+    return 0;
 }
 
 /*
@@ -438,15 +676,133 @@ static void *worker_thread(void *arg) {
     WorkerArgs *args = (WorkerArgs *)arg;
     V8Engine *engine = args->engine;
     ThreadPool *pool = args->pool;
+    int last_fd = -1, burst = 0;
     while (pool->running) {
-        int connfd = dequeue_conn(pool);
+        int connfd = dequeue_conn(pool, args->index);
         if (connfd == -1) break;
-        handle_connection_mt(engine, connfd);
+        if (connfd != last_fd) burst = 0;
+        last_fd = -1;
+        // ::: Pipelined requests are already read, so they are served right here; only an idle connection
+        // --- may move to another worker.
+        PendingBytes carry = { NULL, 0 };
+        int kept;
+        while ((kept = handle_connection_mt(engine, connfd, &carry)) && carry.len > 0) {}
+        if (!kept || !await_next_request(connfd)) continue;
+        // ::: The follow-up request stays on this worker, unless it has had the connection for a while. A
+        // --- worker never blocks on a full ring (that could deadlock with the acceptor), it keeps it
+        // --- instead.
+        if (++burst >= KEEP_ALIVE_BURST && conn_ring_try_push(&pool->conn_queue, connfd) == 0)
+            continue;
+        if (work_deque_push(&pool->deques[args->index], connfd) == 0) {
+            last_fd = connfd;
+        } else {
+            close(connfd);
+        }
     }
     free(args);
     return NULL;
 }
 
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Thread main loop with { acceptPerWorker: true }: the      *
+  * worker accepts on its own SO_REUSEPORT listener and       *
+  * serves the connection itself, with no hand-off through    *
+  * the ring. Keep-alive follow-ups are served inline, so     *
+  * this mode suits many short connections best.              *
+  *************************************************************
+*/
+static void *accepting_worker_thread(void *arg) {
+    WorkerArgs *args = (WorkerArgs *)arg;
+    V8Engine *engine = args->engine;
+    ThreadPool *pool = args->pool;
+    int listen_fd = pool->listen_fds[args->index];
+    if (pool->steer_to_cpu) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(args->index % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+    while (pool->running) {
+        int connfd = accept(listen_fd, NULL, NULL);
+        if (connfd < 0) {
+            if (!pool->running) break;
+            if (errno != EINTR && errno != ECONNABORTED) perror("Accept failed");
+            continue;
+        }
+        PendingBytes carry = { NULL, 0 };
+        while (handle_connection_mt(engine, connfd, &carry) &&
+               (carry.len > 0 || await_next_request(connfd))) {}
+    }
+    free(args);
+    return NULL;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Opens one SO_REUSEPORT listener per worker. With          *
+  * steerToCpu a classic BPF program picks the listener by    *
+  * the CPU that received the connection (CPU % workers), and *
+  * the workers are pinned to match, so a connection is       *
+  * accepted and served on the core whose cache its packets   *
+  * already warmed. The program indexes the whole reuseport   *
+  * group, so it is skipped when prefork processes share it.  *
+  * With more workers than CPUs the group has one listener    *
+  * per CPU, and the extra workers accept on a dup of the     *
+  * listener of the CPU they are pinned to.                   *
+  *************************************************************
+*/
+static void attach_cpu_steering(ThreadPool *pool, int listeners) {
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, (u32)(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, (u32)listeners },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog program = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+    if (server_reuse_port) {
+        fprintf(stderr, "steerToCpu is ignored with --workers: all processes share one reuseport group\n");
+        return;
+    }
+    int fd = pool->listen_fds[0];
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) < 0) {
+        perror("setsockopt(SO_ATTACH_REUSEPORT_CBPF)");
+        return;
+    }
+    pool->steer_to_cpu = 1;
+}
+
+static int open_worker_listeners(ThreadPool *pool, int port, int steer_to_cpu) {
+    per_worker_listeners = 1;
+    // ::: Steering picks listener CPU % group size, so a listener past the CPU count would never be chosen.
+    int listeners = pool->num_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (steer_to_cpu && !server_reuse_port && cpus > 0 && cpus < listeners) listeners = (int)cpus;
+    for (int i = 0; i < pool->num_threads; ++i) {
+        pool->listen_fds[i] =
+            i < listeners ? create_and_bind_socket_mt(port) : dup(pool->listen_fds[i % listeners]);
+        if (pool->listen_fds[i] < 0) return -1;
+    }
+    if (steer_to_cpu) attach_cpu_steering(pool, listeners);
+    dprint("Opened %d per-worker listeners", pool->num_threads);
+    return 0;
+}
+
 /**
   *   __  __
   *  |  \/  |
@@ -457,22 +813,70 @@ static void *worker_thread(void *arg) {
   *
   * Creates a new thread pool for handling connections in the multi-threaded server.
   *
+  * When the script registered the server with { isolatePerWorker: true }, every worker additionally
+  * gets its own isolate and context with the app script replayed into it, so handlers run in parallel
+  * instead of queueing on the primary isolate's v8::Locker.
+  *
   * Returns:
-  *   Pointer to the newly created ThreadPool structure.
+  *   Pointer to the newly created ThreadPool structure, or NULL on failure.
 */
-ThreadPool *create_thread_pool(int num_threads) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return NULL;
+ThreadPool *create_thread_pool(V8Engine *engine, int num_threads) {
+    if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+    // ::: The ring and deques keep their hot counters on separate cache lines, which needs aligned storage.
+    ThreadPool *pool = aligned_alloc(CONN_RING_CACHE_LINE, sizeof(ThreadPool));
+    if (!pool) {
+        perror("aligned_alloc");
+        return NULL;
+    }
+    memset(pool, 0, sizeof(ThreadPool));
+    for (int i = 0; i < MAX_THREADS; ++i)
+        work_deque_init(&pool->deques[i]);
+    if (conn_ring_init(&pool->conn_queue, MAX_QUEUE) != 0) {
+        perror("conn_ring_init");
+        free(pool);
+        return NULL;
+    }
+    pool->num_threads = num_threads;
+    pool->running = 1;
+    pool->server_fd = -1;
+    for (int i = 0; i < MAX_THREADS; ++i)
+        pool->listen_fds[i] = -1;
+
+    if (v8_get_server_options(engine)->isolate_per_worker) {
+        for (int i = 0; i < num_threads; ++i) {
+            pool->worker_engines[i] = v8_create_worker_engine(engine);
+            if (!pool->worker_engines[i]) {
+                fprintf(stderr, "Failed to create isolate for worker %d\n", i);
+                destroy_thread_pool(pool);
+                return NULL;
+            }
+        }
+        dprint("Created %d worker isolates", num_threads);
+    }
+    return pool;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Releases the pool and any per-worker isolates             *
+  *************************************************************
+*/
+static void destroy_thread_pool(ThreadPool *pool) {
+    for (int i = 0; i < pool->num_threads; ++i) {
+        v8_destroy_worker_engine(pool->worker_engines[i]);
+        pool->worker_engines[i] = NULL;
+        if (pool->listen_fds[i] >= 0) close(pool->listen_fds[i]);
+    }
+    conn_ring_destroy(&pool->conn_queue);
+    free(pool);
 }
 
 /*
@@ -491,17 +895,39 @@ ThreadPool *create_thread_pool(int num_threads) {
 */
 int start_server_mt(V8Engine *engine, int port, int num_threads) {
     if (num_threads <= 0) num_threads = DEFAULT_THREADS;
-    ThreadPool *pool = create_thread_pool(num_threads);
-    int server_fd = create_and_bind_socket_mt(port);
-    pool->server_fd = server_fd;
-    if (server_fd < 0) { free(pool); return 1; }
+    telemetry_init();
+    ThreadPool *pool = create_thread_pool(engine, num_threads);
+    if (!pool) return 1;
+    num_threads = pool->num_threads;
+    // ::: With { acceptPerWorker: true } every worker accepts for itself and this thread only waits.
+    const ServerOptions *options = v8_get_server_options(engine);
+    int per_worker = options->accept_per_worker;
+    keep_alive_connections = options->keep_alive;
+    if (per_worker ? open_worker_listeners(pool, port, options->steer_to_cpu) != 0
+                   : (pool->server_fd = create_and_bind_socket_mt(port)) < 0) {
+        destroy_thread_pool(pool);
+        return 1;
+    }
+    int server_fd = pool->server_fd;
+    if (options->js_executor && options->isolate_per_worker) {
+        fprintf(stderr, "jsExecutor is ignored with isolatePerWorker: every worker has its own isolate\n");
+    } else if (options->js_executor) {
+        if (js_executor_start(&pool->executor, engine) != 0) {
+            fprintf(stderr, "Failed to start the JS executor thread\n");
+            close(server_fd);
+            destroy_thread_pool(pool);
+            return 1;
+        }
+        js_executor = &pool->executor;
+    }
     for (int i = 0; i < num_threads; ++i) {
         WorkerArgs *args = malloc(sizeof(WorkerArgs));
-        args->engine = engine;
+        args->engine = pool->worker_engines[i] ? pool->worker_engines[i] : engine;
         args->pool = pool;
-        pthread_create(&pool->threads[i], NULL, worker_thread, args);
+        args->index = i;
+        pthread_create(&pool->threads[i], NULL, per_worker ? accepting_worker_thread : worker_thread, args);
     }
-    while (pool->running) {
+    while (!per_worker && pool->running) {
         int new_socket = accept(server_fd, NULL, NULL);
         if (new_socket < 0) {
             if (!pool->running) break;
@@ -510,12 +936,15 @@ int start_server_mt(V8Engine *engine, int port, int num_threads) {
         }
         enqueue_conn(pool, new_socket);
     }
+    conn_ring_close(&pool->conn_queue);
     for (int i = 0; i < num_threads; ++i) {
         pthread_join(pool->threads[i], NULL);
     }
-    pthread_mutex_destroy(&pool->queue_mutex);
-    pthread_cond_destroy(&pool->queue_cond);
-    free(pool);
+    if (js_executor) {
+        js_executor_stop(js_executor);
+        js_executor = NULL;
+    }
+    destroy_thread_pool(pool);
     printf("Multi-threaded server stopped.\n");
     return 0;
 }
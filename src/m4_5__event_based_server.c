@@ -19,24 +19,63 @@
 * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+// ::: accept4, strcasestr
+#define _GNU_SOURCE
+
 #include "m4_5__event_based_server.h"
 
+#include "timer_wheel.h"
 #include "utils.h"
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <pthread.h>
 #include <time.h>
 #include <sys/timerfd.h>
 #include <ctype.h>
 
 #define MAX_EVENTS 64
+#define MAX_REACTORS 64
 #define READ_BUFFER_SIZE 1024
+#define MAX_HEAD_SIZE (64 * 1024)
+#define MAX_REQUEST_SIZE (64 * 1024 * 1024)
+
+// ::: Idle-time GC. While traffic is recent the loop polls with a short timeout so that quiet gaps are
+// --- noticed quickly and handed to V8 in small slices; once it has been quiet for a while it falls back to
+// --- the long timeout and gives V8 a bigger slice per wakeup.
+#define EPOLL_TIMEOUT_MS 1000
+#define IDLE_POLL_MS 10
+#define IDLE_GC_BUDGET_MS 5
+#define IDLE_GC_LONG_BUDGET_MS 50
+#define BUSY_WINDOW_MS 1000
+#define MEMORY_PRESSURE_CHECK_MS 1000
+
+// ::: Readiness a client socket is watched for; used again when a parked connection is put back.
+#define CLIENT_EPOLL_EVENTS EPOLLIN
+
+// ::: Wheel-driven timeouts: how long an idle keep-alive connection is kept when the client does not ask for
+// --- a timeout of its own, and how long a parked (async) request may take before it is answered with 504.
+#define KEEP_ALIVE_TIMEOUT_S 5
+#define REQUEST_DEADLINE_MS 30000
+
+// ::: JS timer ids: low bits index js_timers, high bits are a generation counter (ids stay positive ints).
+#define JS_TIMER_SLOT_BITS 20
+#define JS_TIMER_SLOT_MASK ((1 << JS_TIMER_SLOT_BITS) - 1)
+#define JS_TIMER_GENERATION_MASK 0x7ffu
+
+// ::: /debug/profile and /debug/heap-sampling: sampling time when the request has no ?seconds=, and the most
+// --- it may ask for.
+#define PROFILE_DEFAULT_SECONDS 10
+#define PROFILE_MAX_SECONDS 300
 
 /**
  *   __  __
@@ -49,12 +88,205 @@
  * Convenience globals for the event-based server.
  * Ideally, they should not be static, but exposed via a context struct.
  * For simplicity, we keep them static here. Feel free to refactor.
+ *
+ * Everything a reactor owns (listening socket, timerfd, timer wheel, connection table, JS timers, debug
+ * requests) is _Thread_local: with { reactors: N } every reactor thread runs the same code against its own
+ * copy, and nothing is shared between loops except the stop flag.
  */
 static volatile sig_atomic_t server_running_eb = 1;
-static int server_fd_global_eb = -1;
-static JSObject interval_callback = NULL;
-static int timer_fd = -1;
-static int interval_ms = 1000;
+static int reactor_count = 1;
+static int batch_limit = 0;
+static _Thread_local int server_fd_global_eb = -1;
+static _Thread_local int timer_fd = -1;
+
+// ::: Every timer of the server (JS timers, keep-alive idle timeouts, request deadlines) lives in this one
+// --- wheel, and timer_fd is only ever armed for the wheel's next expiry.
+static _Thread_local TimerWheel timer_wheel;
+static _Thread_local int timer_wheel_ready = 0;
+static _Thread_local uint64_t timer_fd_expiry_ms = UINT64_MAX;
+
+static int send_response(int fd, int epoll_fd, JSResponse *response, char *response_buffer,
+                         size_t response_size, int keep_alive);
+static void complete_pending_response(void *ctx, JSDispatchResult result, JSResponse *response);
+static void cleanup_request(EvHttpRequest *request);
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * A connection whose handler returned a still-pending Promise. It is taken out of the epoll set until the
+ * promise settles (during a microtask checkpoint of the event loop), so no further input is read from it
+ * and a hang-up cannot close the fd underneath the response. The deadline timer answers 504 instead if
+ * that takes longer than REQUEST_DEADLINE_MS, cancels the parked dispatch by its token and frees this.
+ */
+typedef struct {
+    TimerEntry deadline; /* First, so the wheel's TimerEntry * is the PendingResponse * */
+    uint64_t token;      /* The bridge's handle on the parked dispatch */
+    int fd;
+    int epoll_fd;
+    int keep_alive;
+    int head_only;
+} PendingResponse;
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * A response the socket did not take in one go. Its connection waits for EPOLLOUT instead of EPOLLIN until
+ * resume_response has sent the rest; until then this owns the head and the response (and so the body or
+ * file it points at). `sent` counts head and body bytes together.
+ */
+typedef struct {
+    char *head;
+    size_t head_len;
+    size_t sent;
+    JSResponse response;
+    int keep_alive;
+} OutgoingResponse;
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * Per-connection state, indexed by fd. While the connection waits for its next request, idle_timer closes it
+ * once the keep-alive timeout has passed. A request arrives over as many EPOLLIN events as it takes; the
+ * bytes read of it so far are kept in `in`. While a response is being written (`out`), the same timer drops
+ * a client that stops reading it.
+ */
+typedef struct {
+    TimerEntry idle_timer; /* First, so the wheel's TimerEntry * is the EvConnection * */
+    int fd;
+    int epoll_fd;
+    int keep_alive_timeout_ms;
+    char *in; /* NUL-terminated; NULL until the first byte of a request is read */
+    size_t in_len;
+    size_t in_capacity;
+    int ready; /* Listed in ready_fds */
+    OutgoingResponse *out; /* NULL unless a response is still being written */
+} EvConnection;
+
+static _Thread_local EvConnection **connections = NULL;
+static _Thread_local int connection_capacity = 0;
+
+// ::: Kept-alive connections that already hold (the start of) their next request, read along with the last
+// --- one by a pipelining client. No EPOLLIN announces those bytes, so the loop serves them on its own.
+static _Thread_local int *ready_fds = NULL;
+static _Thread_local int ready_count = 0;
+static _Thread_local int ready_capacity = 0;
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * A request waiting for the rest of its epoll_wait round under ASP.createBatchServer. It owns its read buffer
+ * (the parsed headers point into it) and everything the bridge is handed, since it outlives the event that
+ * read it. Its connection stays in the epoll set: the batch is flushed before the loop polls again.
+ */
+typedef struct {
+    char *buffer;
+    EvHttpRequest request;
+    JSRequest js_request;
+    JSResponse response;
+    JSDispatchJob job;
+    int fd;
+    int epoll_fd;
+    int keep_alive;
+    int head_only;
+} BatchedRequest;
+
+static _Thread_local BatchedRequest *batch_queue[BATCH_SERVER_MAX];
+static _Thread_local int batch_count = 0;
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * A /debug/profile or /debug/heap-sampling request being served (at most one of each). Like a
+ * PendingResponse, its connection is out of the epoll set while the profiler samples; the timer stops the
+ * profiler and writes the profile.
+ */
+typedef struct {
+    TimerEntry timer; /* First, so the wheel's TimerEntry * is the ProfileRequest * */
+    int fd;
+    int epoll_fd;
+    int keep_alive;
+    int active;
+} ProfileRequest;
+
+static _Thread_local ProfileRequest cpu_profile_request;
+static _Thread_local ProfileRequest heap_sampling_request;
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * A setInterval / setTimeout timer. Its id encodes the slot in js_timers plus a generation counter, so a
+ * stale id (of a timer that already fired or was cleared) never cancels a newer timer in the same slot.
+ */
+typedef struct {
+    TimerEntry entry; /* First, so the wheel's TimerEntry * is the JsTimer * */
+    JSObject callback;
+    int interval_ms; /* 0 for a one-shot setTimeout */
+    int id;
+} JsTimer;
+
+static _Thread_local struct {
+    JsTimer **timers; /* By slot; NULL for a free slot */
+    unsigned *generations;
+    int *free_slots;
+    int free_count;
+    int capacity;
+} js_timers;
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Monotonic clock in milliseconds; the timer wheel and the  *
+  * idle bookkeeping of the event loop both run on it.        *
+  *************************************************************
+*/
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void ensure_timer_wheel(void) {
+    if (timer_wheel_ready) return;
+    timer_wheel_init(&timer_wheel, monotonic_ms());
+    timer_wheel_ready = 1;
+}
 
 
 /**
@@ -65,24 +297,25 @@ static int interval_ms = 1000;
  *  | |  | |
  *  |_|  |_| M4
  *
- * Sets or updates the interval timer for the event-based server using a timer file descriptor.
+ * Arms the timer file descriptor for the timer wheel's next expiry (or disarms it when the wheel is empty).
+ * The event loop calls this once per iteration; the syscall is only made when the next expiry has moved.
  *
  * APIs and system calls used:
  *   - `timerfd_settime`: Linux system call to set the expiration interval of a timer file descriptor.
  *   - `struct itimerspec`: POSIX structure to specify timer intervals and initial expiration.
  */
-void initialize_timer(int ms) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static void update_timer_fd(void) {
+    if (timer_fd == -1 || !timer_wheel_ready) return;
+    uint64_t next = timer_wheel_next_expiry(&timer_wheel);
+    if (next == timer_fd_expiry_ms) return;
+
+    // ::: Absolute CLOCK_MONOTONIC time, the same clock as monotonic_ms; an all-zero value disarms.
+    struct itimerspec spec = { 0 };
+    if (next != UINT64_MAX) {
+        spec.it_value.tv_sec = (time_t)(next / 1000);
+        spec.it_value.tv_nsec = (long)(next % 1000) * 1000000;
+    }
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) == 0) timer_fd_expiry_ms = next;
 }
 
 /*
@@ -95,14 +328,244 @@ void initialize_timer(int ms) {
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
-  * Called from SetIntervalImpl to register the callback      *
-  * provided to V8                                            *
+  * Hands out a free js_timers slot, growing the table when   *
+  * none is left. Returns -1 when the table is full.          *
   *************************************************************
 */
-void register_js_interval_callback(int ms, JSObject cb) {
-    interval_callback = cb;
-    interval_ms = ms;
-    initialize_timer(ms);
+static int js_timer_slot_alloc(void) {
+    if (js_timers.free_count > 0) return js_timers.free_slots[--js_timers.free_count];
+    if (js_timers.capacity > JS_TIMER_SLOT_MASK) return -1;
+
+    int capacity = js_timers.capacity ? js_timers.capacity * 2 : 64;
+    JsTimer **timers = realloc(js_timers.timers, capacity * sizeof(*timers));
+    if (!timers) return -1;
+    js_timers.timers = timers;
+    unsigned *generations = realloc(js_timers.generations, capacity * sizeof(*generations));
+    if (!generations) return -1;
+    js_timers.generations = generations;
+    int *free_slots = realloc(js_timers.free_slots, capacity * sizeof(*free_slots));
+    if (!free_slots) return -1;
+    js_timers.free_slots = free_slots;
+
+    for (int slot = capacity - 1; slot >= js_timers.capacity; slot--) {
+        js_timers.timers[slot] = NULL;
+        js_timers.generations[slot] = 0;
+        if (slot > js_timers.capacity) js_timers.free_slots[js_timers.free_count++] = slot;
+    }
+    int slot = js_timers.capacity;
+    js_timers.capacity = capacity;
+    return slot;
+}
+
+static void js_timer_detach(JsTimer *timer) {
+    int slot = timer->id & JS_TIMER_SLOT_MASK;
+    js_timers.timers[slot] = NULL;
+    js_timers.free_slots[js_timers.free_count++] = slot;
+}
+
+static void js_timer_destroy(JsTimer *timer) {
+    v8_free_object(timer->callback);
+    free(timer);
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * Wheel callback of a JS timer: calls the JS function. An interval is re-armed before the call, so that a
+ * clearInterval from inside the callback finds it pending and cancels it; a one-shot timer is taken out of
+ * the id table before the call (clearTimeout of its own id is a no-op) and freed after it.
+ *
+ * APIs used:
+ *   - `v8_call_function_no_arguments`: to call the JavaScript function registered as the callback.
+ */
+static void fire_js_timer(TimerEntry *entry, void *ctx) {
+    V8Engine *engine = ctx;
+    JsTimer *timer = (JsTimer *)entry;
+    JSObject callback = timer->callback;
+    int one_shot = timer->interval_ms == 0;
+    if (one_shot) {
+        js_timer_detach(timer);
+    } else {
+        timer_wheel_add(&timer_wheel, entry, timer_wheel.now_ms + (uint64_t)timer->interval_ms);
+    }
+
+    JSResult result = v8_call_function_no_arguments(engine, callback);
+    if (result.type == JS_STRING) free(result.value.str_result);
+    if (one_shot) js_timer_destroy(timer);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Called from setInterval / setTimeout to register the      *
+  * callback provided to V8. Takes ownership of `cb` and      *
+  * returns the timer id, or 0 when the timer could not be    *
+  * created.                                                  *
+  *************************************************************
+*/
+int register_js_timer(int ms, int repeat, JSObject cb) {
+    ensure_timer_wheel();
+    JsTimer *timer = malloc(sizeof(*timer));
+    int slot = timer ? js_timer_slot_alloc() : -1;
+    if (slot < 0) {
+        free(timer);
+        v8_free_object(cb);
+        return 0;
+    }
+    if (ms < 1) ms = 1;
+
+    unsigned generation = (js_timers.generations[slot] + 1) & JS_TIMER_GENERATION_MASK;
+    if (generation == 0) generation = 1;
+    js_timers.generations[slot] = generation;
+    timer->id = (int)(generation << JS_TIMER_SLOT_BITS | (unsigned)slot);
+    timer->callback = cb;
+    timer->interval_ms = repeat ? ms : 0;
+    timer_entry_init(&timer->entry, fire_js_timer);
+    js_timers.timers[slot] = timer;
+
+    // ::: Relative to the real clock, not to the wheel's own (which only moves when timers fire).
+    timer_wheel_add(&timer_wheel, &timer->entry, monotonic_ms() + (uint64_t)ms);
+    return timer->id;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * clearInterval / clearTimeout.                             *
+  *************************************************************
+*/
+void cancel_js_timer(int id) {
+    int slot = id & JS_TIMER_SLOT_MASK;
+    if (id <= 0 || slot >= js_timers.capacity) return;
+    JsTimer *timer = js_timers.timers[slot];
+    if (!timer || timer->id != id) return;
+    timer_wheel_cancel(&timer_wheel, &timer->entry);
+    js_timer_detach(timer);
+    js_timer_destroy(timer);
+}
+
+// ::: A reactor's timers hold handles into its isolate, so they are let go before the isolate is disposed.
+static void cancel_all_js_timers(void) {
+    for (int slot = 0; slot < js_timers.capacity; slot++) {
+        if (js_timers.timers[slot]) cancel_js_timer(js_timers.timers[slot]->id);
+    }
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Connection bookkeeping. close_connection is the one place *
+  * a client socket is closed, so its idle timer can never    *
+  * outlive it; release_connection either closes it or starts *
+  * waiting for the next keep-alive request (and lists it in  *
+  * ready_fds if that request is partly read already).        *
+  *************************************************************
+*/
+static EvConnection *get_connection(int fd) {
+    return fd >= 0 && fd < connection_capacity ? connections[fd] : NULL;
+}
+
+static void close_connection(int epoll_fd, int fd) {
+    EvConnection *conn = get_connection(fd);
+    if (conn) {
+        timer_wheel_cancel(&timer_wheel, &conn->idle_timer);
+        connections[fd] = NULL;
+        free(conn->in);
+        if (conn->out) {
+            free(conn->out->head);
+            v8_free_response(&conn->out->response);
+            free(conn->out);
+        }
+        free(conn);
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+}
+
+static void close_idle_connection(TimerEntry *entry, void *ctx) {
+    (void)ctx;
+    EvConnection *conn = (EvConnection *)entry;
+    close_connection(conn->epoll_fd, conn->fd);
+}
+
+static void arm_idle_timer(EvConnection *conn) {
+    timer_wheel_add(&timer_wheel, &conn->idle_timer, monotonic_ms() + (uint64_t)conn->keep_alive_timeout_ms);
+}
+
+// ::: Sets what a client socket is watched for, adding it back if it was taken out of the epoll set (parked).
+static void watch_connection(int epoll_fd, int fd, uint32_t events) {
+    struct epoll_event ev = { .events = events, .data.fd = fd };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT)
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void mark_ready(EvConnection *conn) {
+    if (conn->ready) return;
+    if (ready_count == ready_capacity) {
+        int capacity = ready_capacity ? ready_capacity * 2 : 64;
+        int *grown = realloc(ready_fds, capacity * sizeof(*grown));
+        if (!grown) return;
+        ready_fds = grown;
+        ready_capacity = capacity;
+    }
+    ready_fds[ready_count++] = conn->fd;
+    conn->ready = 1;
+}
+
+static void release_connection(int epoll_fd, int fd, int keep_alive) {
+    EvConnection *conn = get_connection(fd);
+    if (keep_alive && conn) {
+        arm_idle_timer(conn);
+        if (conn->in_len > 0) mark_ready(conn);
+    } else {
+        close_connection(epoll_fd, fd);
+    }
+}
+
+static EvConnection *open_connection(int epoll_fd, int fd) {
+    if (fd >= connection_capacity) {
+        int capacity = connection_capacity ? connection_capacity : 256;
+        while (capacity <= fd) capacity *= 2;
+        EvConnection **grown = realloc(connections, capacity * sizeof(*grown));
+        if (!grown) return NULL;
+        memset(grown + connection_capacity, 0, (capacity - connection_capacity) * sizeof(*grown));
+        connections = grown;
+        connection_capacity = capacity;
+    }
+    EvConnection *conn = calloc(1, sizeof(*conn));
+    if (!conn) return NULL;
+    conn->fd = fd;
+    conn->epoll_fd = epoll_fd;
+    conn->keep_alive_timeout_ms = KEEP_ALIVE_TIMEOUT_S * 1000;
+    timer_entry_init(&conn->idle_timer, close_idle_connection);
+    connections[fd] = conn;
+    return conn;
 }
 
 
@@ -130,18 +593,78 @@ void register_js_interval_callback(int ms, JSObject cb) {
  *   - Memory management: malloc(), free()
  *   - String manipulation and parsing: sscanf(), strstr(), strncpy(), strlen(), strtol(), etc
  */
-void parse_http_request_with_header(const char *raw_request, EvHttpRequest *request) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+void parse_http_request_with_header(const char *raw_request, size_t raw_len, EvHttpRequest *request) {
+    memset(request, 0, sizeof(*request));
+    char method[16] = { 0 };
+    char path[2048] = { 0 };
+    char version[16] = { 0 };
+    if (sscanf(raw_request, "%15s %2047s %15s", method, path, version) < 2) return;
+    request->method = strdup(method);
+    request->path = strdup(path);
+    request->http_1_1 = strcmp(version, "HTTP/1.1") == 0;
+
+    const char *header_end = strstr(raw_request, "\r\n\r\n");
+    if (!header_end) return;
+
+    // ::: One header per line between the request line and the blank line.
+    const char *line = strstr(raw_request, "\r\n");
+    while (line && line < header_end && request->header_count < MAX_HEADERS) {
+        line += 2;
+        const char *eol = strstr(line, "\r\n");
+        if (!eol || eol > header_end) eol = header_end;
+        const char *colon = memchr(line, ':', eol - line);
+        if (colon) {
+            const char *value = colon + 1;
+            while (value < eol && (*value == ' ' || *value == '\t')) value++;
+            JSHeader *header = &request->headers[request->header_count++];
+            header->name = (JSSlice){ line, colon - line };
+            header->value = (JSSlice){ value, eol - value };
+        }
+        line = eol;
+    }
+
+    // ::: Sized from what was read, not strlen: a binary body may contain NUL bytes.
+    const char *body = header_end + 4;
+    size_t available = raw_len - (size_t)(body - raw_request);
+    size_t length = available;
+    const char *content_length =
+        http_find_header(raw_request, header_end - raw_request, "Content-Length", NULL);
+    if (content_length) {
+        long parsed = strtol(content_length, NULL, 10);
+        if (parsed >= 0 && (size_t)parsed < available) length = (size_t)parsed;
+    }
+    if (length > 0) {
+        request->body = malloc(length + 1);
+        if (!request->body) return;
+        memcpy(request->body, body, length);
+        request->body[length] = '\0';
+        request->body_size = length;
+    }
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Serializes the head of a filled response. Only the head   *
+  * goes into the buffer; the body stays where the bridge     *
+  * left it and is sent alongside it (and dropped for HEAD).  *
+  *************************************************************
+*/
+static char *build_response_head(JSResponse *response, int head_only, int keep_alive, size_t *response_size) {
+    char *head = http_build_response_head(response, head_only, keep_alive, response_size);
+    if (head_only) {
+        response->body = (JSSlice){ NULL, 0 };
+        static_file_release(response->file);
+        response->file = NULL;
+    }
+    return head;
 }
 
 /**
@@ -152,39 +675,54 @@ void parse_http_request_with_header(const char *raw_request, EvHttpRequest *requ
  *  | |  | |
  *  |_|  |_| M4
  *
- * Handles an HTTP request with keep-alive support by creating a JS object from the request,
- * calling a registered JavaScript handler, and preparing the response.
+ * Handles an HTTP request with keep-alive support by running it through the registered JavaScript handler
+ * and preparing the response head.
  * This method is analogous to the one in m3__multi_threaded_server.c, but also handles keep-alive.
- * You may reuse code from m3__multi_threaded_server.c as needed.
  *
- * Implementation hints:
- *   1. Create a JSObject from the request data (method, path, body).
- *   2. Retrieve the registered JavaScript handler function pointer.
- *   3. Call the handler with the request object and get the response object.
- *   4. Extract status, content type, and body from the response object.
- *   5. Construct an HTTP response string with appropriate headers and body.
- *   6. Handle keep-alive settings in the "Connection" header.
- *   7. Ensure proper error handling and default values.
+ * The whole JS round trip is a single v8_dispatch_request_async call: it builds the request object, calls
+ * the handler and copies { status, headers, body } back out under one set of V8 scopes. A handler whose
+ * promise is still pending leaves the response to `pending` (JS_DISPATCH_PENDING).
+ * http_build_response_head (utils.c) then adds Content-Length, Date, Server and Connection, maps the status
+ * to a reason phrase and fills in default error bodies. The body itself is left in `response` and written
+ * next to the head by write_response.
  *
- * Useful APIs and system calls that you may need:
- *   - v8_create_object: to create a new JS object.
- *   - v8_set_string_property: to set properties on the JS object.
- *   - v8_get_registered_handler_func: to get the registered handler function pointer.
- *   - v8_call_registered_handler_obj: to call the handler with the request object.
- *   - v8_get_number_property: to retrieve numeric properties from the response object.
+ * Useful APIs and system calls used:
+ *   - v8_dispatch_request_async()        : Runs the request through the registered handler.
+ *   - http_build_response_head()         : Serializes the status line and headers.
  */
-static void handle_request(V8Engine *engine, const EvHttpRequest *request, char **response_buffer, size_t *response_size, int keep_alive) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static JSDispatchResult handle_request(V8Engine *engine, EvHttpRequest *request, JSResponse *response,
+                                       char **response_buffer, size_t *response_size, int keep_alive,
+                                       PendingResponse *pending) {
+    *response_buffer = NULL;
+    *response_size = 0;
+    memset(response, 0, sizeof(*response));
+    if (!request->method) return JS_DISPATCH_NO_HANDLER;
+
+    JSRequest js_request = {
+        .method = { request->method, strlen(request->method) },
+        .path = { request->path, request->path ? strlen(request->path) : 0 },
+        .body = { request->body, request->body_size },
+        .headers = request->headers,
+        .header_count = request->header_count,
+        .body_owner = request->body,
+    };
+
+    // ::: One crossing into V8 per request; a NULL response buffer turns into a 500 in write_response.
+    // --- An async handler may leave its promise pending: then `pending` is called back once it settles.
+    pending->head_only = strcmp(request->method, "HEAD") == 0;
+    JSDispatchResult result = v8_dispatch_request_async(engine, &js_request, response,
+                                                        complete_pending_response, pending, &pending->token);
+    // ::: A large body may have been adopted by V8; it now frees it, so cleanup_request must not.
+    request->body = js_request.body_owner;
+    if (result == JS_DISPATCH_TIMEOUT) {
+        // ::: The watchdog terminated the handler so the loop could move on; answer 503 instead of 500.
+        telemetry_increment_timeouts();
+        response->status = 503;
+        *response_buffer = build_response_head(response, pending->head_only, keep_alive, response_size);
+    }
+    if (result != JS_DISPATCH_OK) return result;
+    *response_buffer = build_response_head(response, pending->head_only, keep_alive, response_size);
+    return result;
 }
 
 
@@ -209,17 +747,39 @@ static void handle_request(V8Engine *engine, const EvHttpRequest *request, char
  * - String manipulation functions: strtok(), strncasecmp(), atoi()
  */
 static void parse_keep_alive_headers(const char *buffer, char **http_version, char **connection_hdr, char **keep_alive_hdr, int *keep_alive, int *keep_alive_timeout, int *keep_alive_max) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    *http_version = NULL;
+    *connection_hdr = NULL;
+    *keep_alive_hdr = NULL;
+    *keep_alive = 0;
+    *keep_alive_timeout = KEEP_ALIVE_TIMEOUT_S;
+    *keep_alive_max = 0;
+
+    char version[16] = { 0 };
+    if (sscanf(buffer, "%*15s %*2047s %15s", version) != 1) return;
+    *http_version = strdup(version);
+
+    const char *header_end = strstr(buffer, "\r\n\r\n");
+    size_t head_len = header_end ? (size_t)(header_end - buffer) : strlen(buffer);
+    size_t len = 0;
+    const char *value = http_find_header(buffer, head_len, "Connection", &len);
+    if (value) *connection_hdr = strndup(value, len);
+    value = http_find_header(buffer, head_len, "Keep-Alive", &len);
+    if (value) *keep_alive_hdr = strndup(value, len);
+
+    // ::: HTTP/1.1 keeps the connection unless told to close; HTTP/1.0 only when asked to keep it.
+    if (strcmp(version, "HTTP/1.1") == 0) {
+        *keep_alive = !(*connection_hdr && strcasestr(*connection_hdr, "close"));
+    } else {
+        *keep_alive = *connection_hdr && strcasestr(*connection_hdr, "keep-alive");
+    }
+
+    // ::: Keep-Alive: timeout=5, max=100
+    if (*keep_alive_hdr) {
+        const char *timeout = strcasestr(*keep_alive_hdr, "timeout=");
+        if (timeout && atoi(timeout + 8) > 0) *keep_alive_timeout = atoi(timeout + 8);
+        const char *max = strcasestr(*keep_alive_hdr, "max=");
+        if (max && atoi(max + 4) > 0) *keep_alive_max = atoi(max + 4);
+    }
 }
 
 
@@ -241,17 +801,11 @@ static void parse_keep_alive_headers(const char *buffer, char **http_version, ch
  *   - `v8_call_function_no_arguments`: to call the JavaScript function registered as the interval callback.
  */
 static void handle_timer_event(V8Engine *engine) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    uint64_t expirations;
+    if (read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) perror("read(timerfd)");
+    // ::: The timerfd is one-shot: it has to be armed again for whatever is next.
+    timer_fd_expiry_ms = UINT64_MAX;
+    timer_wheel_advance(&timer_wheel, monotonic_ms(), engine);
 }
 
 /**
@@ -278,17 +832,23 @@ static void handle_timer_event(V8Engine *engine) {
  * - Epoll operations: epoll_ctl()
  */
 static void handle_new_connection(int server_fd, int epoll_fd, struct epoll_event *ev) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    // ::: Drain the accept queue: one readiness event may stand for many pending connections.
+    for (;;) {
+        int client_fd = accept4(server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept4");
+            return;
+        }
+        EvConnection *conn = open_connection(epoll_fd, client_fd);
+        ev->events = CLIENT_EPOLL_EVENTS;
+        ev->data.fd = client_fd;
+        if (!conn || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, ev) < 0) {
+            close_connection(epoll_fd, client_fd);
+            continue;
+        }
+        // ::: A connection that never sends a request is dropped like an idle keep-alive one.
+        arm_idle_timer(conn);
+    }
 }
 
 /**
@@ -308,20 +868,76 @@ static void handle_new_connection(int server_fd, int epoll_fd, struct epoll_even
  * APIs and system calls that you may need:
  * - Socket operations: read(), close()
  * - Epoll operations: epoll_ctl()
+ *
+ * A request may take any number of EPOLLIN events to arrive. The bytes read so far stay in the connection
+ * until the head and its whole Content-Length body are in; reading stops there, and the few bytes of a
+ * pipelined next request that the last read may have taken along are kept for that one. Progress restarts
+ * the idle timer, so only a client that stalls mid-request is dropped.
+ *
+ * Returns the complete request (malloc'd and NUL-terminated, `*request_len` bytes, freed by the caller), or
+ * NULL while it is incomplete or once the connection has been closed.
  */
-static int read_and_validate_client_request(int fd, char *buffer, struct epoll_event *ev, int epoll_fd) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return 0;
+static char *read_and_validate_client_request(int fd, struct epoll_event *ev, int epoll_fd,
+                                              size_t *request_len) {
+    (void)ev;
+    EvConnection *conn = get_connection(fd);
+    if (!conn) {
+        close_connection(epoll_fd, fd);
+        return NULL;
+    }
+    size_t expected = 0;
+    int progress = 0;
+    for (;;) {
+        if (!expected && conn->in) {
+            const char *header_end = strstr(conn->in, "\r\n\r\n");
+            if (header_end) {
+                size_t head_len = (size_t)(header_end + 4 - conn->in);
+                const char *content_length = http_find_header(conn->in, head_len, "Content-Length", NULL);
+                long body_len = content_length ? strtol(content_length, NULL, 10) : 0;
+                if (body_len < 0 || body_len > MAX_REQUEST_SIZE) break;
+                expected = head_len + (size_t)body_len;
+            } else if (conn->in_len > MAX_HEAD_SIZE) {
+                break;
+            }
+        }
+        if (expected && conn->in_len >= expected) {
+            char *request = conn->in;
+            size_t surplus = conn->in_len - expected;
+            conn->in = NULL;
+            conn->in_len = conn->in_capacity = 0;
+            if (surplus > 0 && (conn->in = malloc(surplus + READ_BUFFER_SIZE + 1))) {
+                memcpy(conn->in, request + expected, surplus);
+                conn->in[surplus] = '\0';
+                conn->in_len = surplus;
+                conn->in_capacity = surplus + READ_BUFFER_SIZE;
+            }
+            request[expected] = '\0';
+            *request_len = expected;
+            return request;
+        }
+        if (conn->in_len == conn->in_capacity) {
+            // ::: Once Content-Length is known, grow straight to the final size instead of doubling.
+            size_t capacity = conn->in_capacity ? conn->in_capacity * 2 : READ_BUFFER_SIZE;
+            if (expected > conn->in_capacity) capacity = expected;
+            if (capacity > MAX_REQUEST_SIZE) break;
+            char *grown = realloc(conn->in, capacity + 1);
+            if (!grown) break;
+            conn->in = grown;
+            conn->in_capacity = capacity;
+        }
+        ssize_t n = read(fd, conn->in + conn->in_len, conn->in_capacity - conn->in_len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (progress) arm_idle_timer(conn);
+            return NULL;
+        }
+        if (n <= 0) break;
+        conn->in_len += (size_t)n;
+        conn->in[conn->in_len] = '\0';
+        progress = 1;
+    }
+    close_connection(epoll_fd, fd);
+    return NULL;
 }
 
 /**
@@ -350,20 +966,31 @@ static int read_and_validate_client_request(int fd, char *buffer, struct epoll_e
  * - Epoll operations: epoll_ctl()
  * - telemetry_get_request_count: to get the number of handled requests.
  * - telemetry_get_start_time: to get the server's start time.
+ *
+ * The JSON also carries the isolate's heap statistics and GC pause totals (telemetry_format_json), including
+ * the average GC pause time per request.
  */
-static int handle_telemetry_endpoint(int fd, int epoll_fd, EvHttpRequest *request, int keep_alive) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return 0;
+static int handle_telemetry_endpoint(V8Engine *engine, int fd, int epoll_fd, EvHttpRequest *request,
+                                     int keep_alive) {
+    if (!request->method || !request->path) return 0;
+    if (strcmp(request->method, "GET") != 0 || strcmp(request->path, "/telemetry") != 0) return 0;
+
+    char body[1024];
+    int body_len = telemetry_format_json(engine, body, sizeof(body));
+    if (body_len < 0 || (size_t)body_len >= sizeof(body)) body_len = 0;
+    static const char content_type_name[] = "Content-Type";
+    static const char content_type_value[] = "application/json";
+    JSResponse response = {
+        .status = 200,
+        .headers = { { { content_type_name, sizeof(content_type_name) - 1 },
+                       { content_type_value, sizeof(content_type_value) - 1 } } },
+        .header_count = 1,
+        .body = { body, (size_t)body_len },
+    };
+    size_t head_len = 0;
+    char *head = http_build_response_head(&response, 0, keep_alive, &head_len);
+    send_response(fd, epoll_fd, &response, head, head_len, keep_alive);
+    return 1;
 }
 
 /**
@@ -381,21 +1008,289 @@ static int handle_telemetry_endpoint(int fd, int epoll_fd, EvHttpRequest *reques
  *   2. If the buffer is valid, write the response to the client and frees the buffer.
  *   3. If the buffer is NULL, write a generic HTTP 500 Internal Server Error response to the client.
  *
+ * The head and body are gathered into one sendmsg (see http_send_response_partial), so a body that lives in
+ * an ArrayBuffer's backing store is written from there without being copied into the head buffer first.
+ * A file body goes out with sendfile instead (see http_send_file_partial).
+ *
+ * Nothing here waits for the socket. What it does not take right away is handed to the connection, which
+ * then waits for EPOLLOUT (see resume_response) while the loop serves everyone else; a multi-megabyte file
+ * or ArrayBuffer going to a slow client no longer holds up the reactor. Returns 0 once the response is out,
+ * 1 if the connection took it over (the buffer and `response` are then its to release), -1 on error.
  */
-static void write_response(int fd, char *response_buffer, size_t response_size) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static int write_response(int fd, char *response_buffer, size_t response_size, JSResponse *response,
+                          int keep_alive) {
+    static const char internal_error[] = "HTTP/1.1 500 Internal Server Error\r\n"
+                                         "Content-Type: text/plain\r\n"
+                                         "Content-Length: 21\r\n"
+                                         "Server: asp-v8/1.0\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n"
+                                         "Internal Server Error";
+    if (!response_buffer) {
+        v8_free_response(response);
+        response_buffer = malloc(sizeof(internal_error));
+        if (!response_buffer) return -1;
+        memcpy(response_buffer, internal_error, sizeof(internal_error));
+        response_size = sizeof(internal_error) - 1;
+    }
+    size_t sent = 0;
+    int rc = response->file
+                 ? http_send_file_partial(fd, response_buffer, response_size, response->file, &sent)
+                 : http_send_response_partial(fd, response_buffer, response_size, response->body, &sent);
+    EvConnection *conn = rc == 1 ? get_connection(fd) : NULL;
+    OutgoingResponse *out = conn ? malloc(sizeof(*out)) : NULL;
+    if (!out) {
+        free(response_buffer);
+        return rc == 0 ? 0 : -1;
+    }
+    *out = (OutgoingResponse){ .head = response_buffer, .head_len = response_size, .sent = sent,
+                               .response = *response, .keep_alive = keep_alive };
+    memset(response, 0, sizeof(*response));
+    // ::: A body the response does not own (e.g. a caller's stack buffer) has to outlive this call now.
+    JSResponse *owned = &out->response;
+    if (owned->body.ptr && !owned->storage && !owned->body_hold) {
+        owned->storage = malloc(owned->body.len ? owned->body.len : 1);
+        if (!owned->storage) {
+            free(out->head);
+            v8_free_response(owned);
+            free(out);
+            return -1;
+        }
+        memcpy(owned->storage, owned->body.ptr, owned->body.len);
+        owned->body.ptr = owned->storage;
+    }
+    conn->out = out;
+    watch_connection(conn->epoll_fd, fd, EPOLLOUT);
+    arm_idle_timer(conn);
+    return 1;
 }
 
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * EPOLLOUT on a connection with a response in flight: sends *
+  * what the socket takes now. Once all of it is out, the     *
+  * connection goes back to reading requests (or is closed),  *
+  * as send_response would have done right away.              *
+  *************************************************************
+*/
+static void resume_response(EvConnection *conn) {
+    OutgoingResponse *out = conn->out;
+    size_t before = out->sent;
+    JSResponse *response = &out->response;
+    int rc = response->file
+                 ? http_send_file_partial(conn->fd, out->head, out->head_len, response->file, &out->sent)
+                 : http_send_response_partial(conn->fd, out->head, out->head_len, response->body, &out->sent);
+    if (rc == 1) {
+        // ::: Only a client that stops reading runs into the idle timeout.
+        if (out->sent > before) arm_idle_timer(conn);
+        return;
+    }
+    int fd = conn->fd;
+    int epoll_fd = conn->epoll_fd;
+    int keep_alive = rc == 0 && out->keep_alive;
+    conn->out = NULL;
+    free(out->head);
+    v8_free_response(&out->response);
+    free(out);
+    if (keep_alive) watch_connection(epoll_fd, fd, CLIENT_EPOLL_EVENTS);
+    release_connection(epoll_fd, fd, keep_alive);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Writes a response, releases it and closes the connection  *
+  * unless it is kept alive. A NULL response buffer sends the *
+  * canned 500. Returns 1 if the connection now waits for its *
+  * next request, so a parked one has to be put back into the *
+  * epoll set; 0 if it was closed, or is still being written  *
+  * to and will be released once that is done.                *
+  *************************************************************
+*/
+static int send_response(int fd, int epoll_fd, JSResponse *response, char *response_buffer,
+                         size_t response_size, int keep_alive) {
+    int rc = write_response(fd, response_buffer, response_size, response, keep_alive);
+    if (rc == 1) return 0;
+    v8_free_response(response);
+    keep_alive = keep_alive && rc == 0;
+    release_connection(epoll_fd, fd, keep_alive);
+    return keep_alive;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * send_response for the answer to a request: also counts    *
+  * it.                                                       *
+  *************************************************************
+*/
+static int finish_response(int fd, int epoll_fd, JSResponse *response, char *response_buffer,
+                           size_t response_size, int keep_alive) {
+    telemetry_increment_request_count();
+    if (response_buffer && response->status == 200) telemetry_increment_200_responses();
+    return send_response(fd, epoll_fd, response, response_buffer, response_size, keep_alive);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Deadline of a parked request: answers 504, closes the     *
+  * connection and cancels the dispatch, so the bridge drops  *
+  * its side and a late settle of the promise finds nothing   *
+  * to call back.                                             *
+  *************************************************************
+*/
+static void expire_pending_response(TimerEntry *entry, void *ctx) {
+    V8Engine *engine = ctx;
+    PendingResponse *pending = (PendingResponse *)entry;
+    JSResponse timeout = { .status = 504 };
+    size_t head_len = 0;
+    char *head = http_build_response_head(&timeout, pending->head_only, 0, &head_len);
+    finish_response(pending->fd, pending->epoll_fd, &timeout, head, head_len, 0);
+    v8_cancel_dispatch(engine, pending->token);
+    free(pending);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Called from a microtask checkpoint when a parked handler  *
+  * promise settles. Writes the response and, for keep-alive  *
+  * connections, puts the socket back into the epoll set.     *
+  *************************************************************
+*/
+static void complete_pending_response(void *ctx, JSDispatchResult result, JSResponse *response) {
+    PendingResponse *pending = ctx;
+    timer_wheel_cancel(&timer_wheel, &pending->deadline);
+    char *response_buffer = NULL;
+    size_t response_size = 0;
+    int keep_alive = pending->keep_alive;
+    if (result == JS_DISPATCH_OK) {
+        response_buffer = build_response_head(response, pending->head_only, keep_alive, &response_size);
+    }
+    if (!response_buffer) keep_alive = 0;
+
+    if (finish_response(pending->fd, pending->epoll_fd, response, response_buffer, response_size, keep_alive))
+        watch_connection(pending->epoll_fd, pending->fd, CLIENT_EPOLL_EVENTS);
+    free(pending);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Answers every queued request with one crossing into V8:   *
+  * v8_dispatch_batch hands them to the batch handler as one  *
+  * array. Results are turned into responses as in            *
+  * handle_request.                                           *
+  *************************************************************
+*/
+static void flush_batch(V8Engine *engine) {
+    if (batch_count == 0) return;
+    JSDispatchJob *jobs[BATCH_SERVER_MAX];
+    for (int i = 0; i < batch_count; i++) jobs[i] = &batch_queue[i]->job;
+    v8_dispatch_batch(engine, jobs, (size_t)batch_count);
+
+    for (int i = 0; i < batch_count; i++) {
+        BatchedRequest *batched = batch_queue[i];
+        // ::: A large body may have been adopted by V8; it now frees it, so cleanup_request must not.
+        batched->request.body = batched->js_request.body_owner;
+        char *response_buffer = NULL;
+        size_t response_size = 0;
+        JSDispatchResult result = batched->job.result;
+        if (result == JS_DISPATCH_TIMEOUT) {
+            telemetry_increment_timeouts();
+            batched->response.status = 503;
+        }
+        if (result == JS_DISPATCH_OK || result == JS_DISPATCH_TIMEOUT) {
+            response_buffer = build_response_head(&batched->response, batched->head_only, batched->keep_alive,
+                                                  &response_size);
+        }
+        int keep_alive = response_buffer ? batched->keep_alive : 0;
+        finish_response(batched->fd, batched->epoll_fd, &batched->response, response_buffer, response_size,
+                        keep_alive);
+        cleanup_request(&batched->request);
+        free(batched->buffer);
+        free(batched);
+    }
+    batch_count = 0;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Adds a parsed request to this round's batch, and flushes  *
+  * the batch once it holds batch_limit requests.             *
+  *************************************************************
+*/
+static void queue_batched_request(V8Engine *engine, BatchedRequest *batched, int fd, int epoll_fd,
+                                  int keep_alive) {
+    EvHttpRequest *request = &batched->request;
+    batched->fd = fd;
+    batched->epoll_fd = epoll_fd;
+    batched->keep_alive = keep_alive;
+    batched->head_only = strcmp(request->method, "HEAD") == 0;
+    batched->js_request = (JSRequest){
+        .method = { request->method, strlen(request->method) },
+        .path = { request->path, request->path ? strlen(request->path) : 0 },
+        .body = { request->body, request->body_size },
+        .headers = request->headers,
+        .header_count = request->header_count,
+        .body_owner = request->body,
+    };
+    batched->job = (JSDispatchJob){ .request = &batched->js_request, .response = &batched->response };
+    batch_queue[batch_count++] = batched;
+    if (batch_count >= batch_limit) flush_batch(engine);
+}
 
 /**
  *   __  __
@@ -409,7 +1304,8 @@ static void write_response(int fd, char *response_buffer, size_t response_size)
  * and sending the appropriate response back to the client.
  *
  * Implementation hints:
- *   1. Validate the presence of the "Host" header; if missing, respond with a 400 Bad Request.
+ *   1. Validate the presence of the "Host" header on HTTP/1.1 requests; if missing, respond with a 400 Bad
+ *      Request.
  *   2. Determine if the request method is "HEAD" to handle it accordingly.
  *   3. Call `handle_request` to process the request and obtain the response buffer and size.
  *   4. If a response buffer is returned, add a "Date" header to it.
@@ -422,19 +1318,56 @@ static void write_response(int fd, char *response_buffer, size_t response_size)
  * - Socket operations: write(), close()
  * - Epoll operations: epoll_ctl()
  *
+ * Under ASP.createBatchServer the request is queued in `batched` instead and 1 is returned: the batch then
+ * owns the request and answers it in flush_batch.
  */
-static void handle_generic_request(V8Engine *engine, int fd, int epoll_fd, EvHttpRequest *request, int keep_alive) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+static int handle_generic_request(V8Engine *engine, int fd, int epoll_fd, EvHttpRequest *request,
+                                  int keep_alive, BatchedRequest *batched) {
+    char *response_buffer = NULL;
+    size_t response_size = 0;
+    JSResponse response;
+    memset(&response, 0, sizeof(response));
+
+    // ::: Host is only mandatory from HTTP/1.1 on; HTTP/1.0 clients may leave it out.
+    int host_ok = !request->http_1_1;
+    for (int i = 0; i < request->header_count; i++) {
+        JSSlice name = request->headers[i].name;
+        if (name.len == 4 && strncasecmp(name.ptr, "Host", 4) == 0) host_ok = 1;
+    }
+    if (!host_ok) {
+        // ::: HTTP/1.1 requires Host; http_build_response_head fills in the "Bad Request" body.
+        JSResponse bad_request = { .status = 400 };
+        keep_alive = 0;
+        response_buffer = http_build_response_head(&bad_request, 0, keep_alive, &response_size);
+    } else if (batch_limit > 0) {
+        // ::: The batch handler only takes arrays, so a request that could not get its own slot gets a 500.
+        if (batched) {
+            queue_batched_request(engine, batched, fd, epoll_fd, keep_alive);
+            return 1;
+        }
+        keep_alive = 0;
+    } else {
+        PendingResponse *pending = malloc(sizeof(*pending));
+        if (!pending) {
+            finish_response(fd, epoll_fd, &response, NULL, 0, 0);
+            return 0;
+        }
+        *pending = (PendingResponse){ .fd = fd, .epoll_fd = epoll_fd, .keep_alive = keep_alive };
+        timer_entry_init(&pending->deadline, expire_pending_response);
+        JSDispatchResult result =
+            handle_request(engine, request, &response, &response_buffer, &response_size, keep_alive, pending);
+        if (result == JS_DISPATCH_PENDING) {
+            // ::: Parked: the response is written by complete_pending_response once the promise settles, or
+            // --- by expire_pending_response if it does not settle in time.
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            timer_wheel_add(&timer_wheel, &pending->deadline, monotonic_ms() + REQUEST_DEADLINE_MS);
+            return 0;
+        }
+        free(pending);
+        if (!response_buffer) keep_alive = 0;
+    }
+    finish_response(fd, epoll_fd, &response, response_buffer, response_size, keep_alive);
+    return 0;
 }
 
 /*
@@ -447,14 +1380,216 @@ static void handle_generic_request(V8Engine *engine, int fd, int epoll_fd, EvHtt
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
+  * Hands a debug endpoint's connection back: closed, or      *
+  * waiting for its next request. A parked connection also    *
+  * goes back into the epoll set.                             *
   *************************************************************
 */
-static void cleanup_request(EvHttpRequest *request) {
-    for (size_t i = 0; i < request->header_count; i++) {
-        free(request->headers[i].name);
-        free(request->headers[i].value);
+static void release_debug_connection(int fd, int epoll_fd, int keep_alive, int parked) {
+    release_connection(epoll_fd, fd, keep_alive);
+    if (parked && keep_alive) watch_connection(epoll_fd, fd, CLIENT_EPOLL_EVENTS);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Writes a response generated by the server itself (debug   *
+  * endpoints). `body` is malloc'd or NULL and is freed here. *
+  *************************************************************
+*/
+static void send_debug_response(int fd, int epoll_fd, int status, char *body, size_t body_len, int keep_alive,
+                                int parked) {
+    static const char content_type_name[] = "Content-Type";
+    static const char content_type_value[] = "application/json";
+    JSResponse response = {
+        .status = status,
+        .headers = { { { content_type_name, sizeof(content_type_name) - 1 },
+                       { content_type_value, sizeof(content_type_value) - 1 } } },
+        .header_count = body ? 1 : 0,
+        .body = { body, body_len },
+        .storage = body,
+    };
+    size_t head_len = 0;
+    char *head = http_build_response_head(&response, 0, keep_alive, &head_len);
+    if (!head) keep_alive = 0;
+    if (send_response(fd, epoll_fd, &response, head, head_len, keep_alive) && parked)
+        watch_connection(epoll_fd, fd, CLIENT_EPOLL_EVENTS);
+}
+
+static int write_socket_chunk(void *ctx, const char *data, size_t len) {
+    return http_send_chunk(*(int *)ctx, data, len);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Streams a document produced by the engine (heap snapshot, *
+  * allocation profile) as a chunked JSON response, straight  *
+  * from V8's serializer to the socket. A failure after the   *
+  * head is out can only be reported by closing the           *
+  * connection mid-body.                                      *
+  *************************************************************
+*/
+static void stream_debug_response(V8Engine *engine, int fd, int epoll_fd, int keep_alive, int parked,
+                                  int (*produce)(V8Engine *, JSChunkWriter, void *)) {
+    static const char content_type_name[] = "Content-Type";
+    static const char content_type_value[] = "application/json";
+    static const char encoding_name[] = "Transfer-Encoding";
+    static const char encoding_value[] = "chunked";
+    JSResponse response = {
+        .status = 200,
+        .headers = { { { content_type_name, sizeof(content_type_name) - 1 },
+                       { content_type_value, sizeof(content_type_value) - 1 } },
+                     { { encoding_name, sizeof(encoding_name) - 1 },
+                       { encoding_value, sizeof(encoding_value) - 1 } } },
+        .header_count = 2,
+    };
+    size_t head_len = 0;
+    char *head = http_build_response_head(&response, 0, keep_alive, &head_len);
+    if (!head || http_send_response(fd, head, head_len, (JSSlice){ NULL, 0 }) != 0 ||
+        produce(engine, write_socket_chunk, &fd) != 0 || http_send_chunk(fd, NULL, 0) != 0)
+        keep_alive = 0;
+    free(head);
+    release_debug_connection(fd, epoll_fd, keep_alive, parked);
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Timers of the parked profile requests: stop the profiler  *
+  * and answer with the .cpuprofile JSON, or stream the       *
+  * .heapprofile.                                             *
+  *************************************************************
+*/
+static void finish_cpu_profile(TimerEntry *entry, void *ctx) {
+    ProfileRequest *profile = (ProfileRequest *)entry;
+    size_t length = 0;
+    char *json = v8_cpu_profile_stop((V8Engine *)ctx, &length);
+    profile->active = 0;
+    int status = json ? 200 : 500;
+    send_debug_response(profile->fd, profile->epoll_fd, status, json, length, profile->keep_alive, 1);
+}
+
+static void finish_heap_sampling(TimerEntry *entry, void *ctx) {
+    ProfileRequest *profile = (ProfileRequest *)entry;
+    profile->active = 0;
+    stream_debug_response((V8Engine *)ctx, profile->fd, profile->epoll_fd, profile->keep_alive, 1,
+                          v8_heap_sampling_stop);
+}
+
+static int debug_path_is(EvHttpRequest *request, const char *path) {
+    size_t path_len = strcspn(request->path, "?");
+    return strcmp(request->method, "GET") == 0 && path_len == strlen(path) &&
+           strncmp(request->path, path, path_len) == 0;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Starts a profiler and parks the connection until the      *
+  * request's ?seconds= are up, while the loop keeps serving  *
+  * (and the profiler keeps sampling) regular traffic.        *
+  *************************************************************
+*/
+static void start_profile_request(V8Engine *engine, ProfileRequest *profile, int (*start)(V8Engine *),
+                                  TimerCallback finish, int fd, int epoll_fd, EvHttpRequest *request,
+                                  int keep_alive) {
+    int seconds = PROFILE_DEFAULT_SECONDS;
+    const char *query = strstr(request->path + strcspn(request->path, "?"), "seconds=");
+    if (query) seconds = atoi(query + strlen("seconds="));
+    if (seconds < 1) seconds = 1;
+    if (seconds > PROFILE_MAX_SECONDS) seconds = PROFILE_MAX_SECONDS;
+
+    if (profile->active) {
+        send_debug_response(fd, epoll_fd, 409, NULL, 0, keep_alive, 0);
+        return;
+    }
+    if (start(engine) != 0) {
+        send_debug_response(fd, epoll_fd, 500, NULL, 0, keep_alive, 0);
+        return;
     }
+    *profile = (ProfileRequest){ .fd = fd, .epoll_fd = epoll_fd, .keep_alive = keep_alive, .active = 1 };
+    timer_entry_init(&profile->timer, finish);
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    timer_wheel_add(&timer_wheel, &profile->timer, monotonic_ms() + (uint64_t)seconds * 1000);
+}
 
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Serves the debug endpoints when they are enabled, without *
+  * calling the JS handler: GET /debug/profile?seconds=N (CPU *
+  * profile), GET /debug/heap (heap snapshot, taken and       *
+  * streamed right away) and GET /debug/heap-                 *
+  * sampling?seconds=N (sampled allocations). Returns 1 if    *
+  * the request was handled.                                  *
+  *************************************************************
+*/
+static int handle_debug_endpoint(V8Engine *engine, int fd, int epoll_fd, EvHttpRequest *request,
+                                 int keep_alive) {
+    if (!debug_endpoints_enabled || !request->method || !request->path) return 0;
+    if (debug_path_is(request, "/debug/profile")) {
+        start_profile_request(engine, &cpu_profile_request, v8_cpu_profile_start, finish_cpu_profile, fd,
+                              epoll_fd, request, keep_alive);
+    } else if (debug_path_is(request, "/debug/heap-sampling")) {
+        start_profile_request(engine, &heap_sampling_request, v8_heap_sampling_start, finish_heap_sampling,
+                              fd, epoll_fd, request, keep_alive);
+    } else if (debug_path_is(request, "/debug/heap")) {
+        stream_debug_response(engine, fd, epoll_fd, keep_alive, 0, v8_heap_snapshot_write);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  *************************************************************
+*/
+static void cleanup_request(EvHttpRequest *request) {
     free(request->method);
     free(request->path);
     free(request->body);
@@ -474,21 +1609,59 @@ static void cleanup_request(EvHttpRequest *request) {
   *************************************************************
 */
 static void handle_client_event(V8Engine *engine, int fd, struct epoll_event *ev, int epoll_fd) {
-    char buffer[READ_BUFFER_SIZE] = { 0 };
-    if (!read_and_validate_client_request(fd, buffer, ev, epoll_fd)) return;
-    EvHttpRequest request = { 0 };
-    parse_http_request_with_header(buffer, &request);
+    // ::: A connection still writing its last response only watches EPOLLOUT (or EPOLLERR / EPOLLHUP).
+    EvConnection *writing = get_connection(fd);
+    if (writing && writing->out) {
+        resume_response(writing);
+        return;
+    }
+    size_t read_len = 0;
+    char *buffer = read_and_validate_client_request(fd, ev, epoll_fd, &read_len);
+    if (!buffer) return;
+    // ::: A request that may be batched can outlive this call, so it gets its own slot, which owns the
+    // --- buffer.
+    BatchedRequest *batched = batch_limit > 0 ? malloc(sizeof(*batched)) : NULL;
+    if (batched) batched->buffer = buffer;
+    EvHttpRequest local_request = { 0 };
+    EvHttpRequest *request = batched ? &batched->request : &local_request;
+    parse_http_request_with_header(buffer, read_len, request);
     int keep_alive, keep_alive_timeout, keep_alive_max;
     char *http_version = NULL;
     char *connection_hdr = NULL;
     char *keep_alive_hdr = NULL;
     parse_keep_alive_headers(buffer, &http_version, &connection_hdr, &keep_alive_hdr, &keep_alive, &keep_alive_timeout, &keep_alive_max);
-    if (handle_telemetry_endpoint(fd, epoll_fd, &request, keep_alive)) {
-        cleanup_request(&request);
+    free(http_version);
+    free(connection_hdr);
+    free(keep_alive_hdr);
+
+    // ::: The connection is busy now; its idle timer restarts (with the client's timeout) after the response.
+    EvConnection *conn = get_connection(fd);
+    if (conn) {
+        timer_wheel_cancel(&timer_wheel, &conn->idle_timer);
+        conn->keep_alive_timeout_ms = keep_alive_timeout * 1000;
+    }
+    if (!handle_telemetry_endpoint(engine, fd, epoll_fd, request, keep_alive) &&
+        !handle_debug_endpoint(engine, fd, epoll_fd, request, keep_alive) &&
+        handle_generic_request(engine, fd, epoll_fd, request, keep_alive, batched)) {
         return;
     }
-    handle_generic_request(engine, fd, epoll_fd, &request, keep_alive);
-    cleanup_request(&request);
+    cleanup_request(request);
+    free(buffer);
+    free(batched);
+}
+
+// ::: Serves the connections listed in ready_fds from the bytes they already hold. One still busy with an
+// --- earlier request (parked or batched) is listed again when it is released.
+static void serve_ready_connections(V8Engine *engine, int epoll_fd, struct epoll_event *ev) {
+    int count = ready_count;
+    for (int i = 0; i < count; i++) {
+        EvConnection *conn = get_connection(ready_fds[i]);
+        if (!conn || !conn->ready) continue;
+        conn->ready = 0;
+        if (timer_entry_pending(&conn->idle_timer)) handle_client_event(engine, conn->fd, ev, epoll_fd);
+    }
+    memmove(ready_fds, ready_fds + count, (size_t)(ready_count - count) * sizeof(*ready_fds));
+    ready_count -= count;
 }
 
 
@@ -511,17 +1684,17 @@ static void handle_client_event(V8Engine *engine, int fd, struct epoll_event *ev
  *   - `timerfd_settime`: to set the timer's expiration interval.
  */
 static int setup_timer_fd() {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        perror("timerfd_create");
+        return -1;
+    }
+    // ::: Timers registered while the script ran (before the loop existed) are already in the wheel.
+    ensure_timer_wheel();
+    timer_fd = fd;
+    timer_fd_expiry_ms = UINT64_MAX;
+    update_timer_fd();
+    return fd;
 }
 
 
@@ -543,17 +1716,41 @@ static int setup_timer_fd() {
  * - Socket operations: socket(), setsockopt(), fcntl(), bind(), listen()
  */
 static int setup_server_fd(int port) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int enabled = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled)) < 0) {
+        perror("setsockopt(SO_REUSEADDR)");
+        close(server_fd);
+        return -1;
+    }
+    // ::: Prefork workers and reactors all bind the same port; the kernel spreads incoming connections over
+    // --- them, and a connection stays with the socket (and so the reactor) that accepted it.
+    int reuse_port = server_reuse_port || reactor_count > 1;
+    if (reuse_port && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) < 0) {
+        perror("setsockopt(SO_REUSEPORT)");
+        close(server_fd);
+        return -1;
+    }
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons((u16)port),
+    };
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("bind");
+        close(server_fd);
+        return -1;
+    }
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        perror("listen");
+        close(server_fd);
+        return -1;
+    }
+    return server_fd;
 }
 
 /**
@@ -576,17 +1773,23 @@ static int setup_server_fd(int port) {
  * - Epoll operations: epoll_create1(), epoll_ctl()
  */
 static int setup_epoll_fd(int server_fd, int timer_fd, struct epoll_event *ev, struct epoll_event *events) {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    (void)events;
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    const int fds[] = { server_fd, timer_fd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        ev->events = EPOLLIN;
+        ev->data.fd = fds[i];
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i], ev) < 0) {
+            perror("epoll_ctl");
+            close(epoll_fd);
+            return -1;
+        }
+    }
+    return epoll_fd;
 }
 
 /*
@@ -599,17 +1802,38 @@ static int setup_epoll_fd(int server_fd, int timer_fd, struct epoll_event *ev, s
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
-  * Main event loop                                           *
+  * Main event loop. An epoll_wait that times out means       *
+  * nothing is pending, so that gap is given to V8            *
+  * (v8_run_idle_tasks) for GC work it would otherwise do in  *
+  * the middle of the next request. Every iteration ends with *
+  * one microtask checkpoint, which is where async handlers   *
+  * resume. The process RSS is compared against the memory    *
+  * pressure threshold at most once per second.               *
   *************************************************************
 */
 static void event_loop(V8Engine *engine, int server_fd, int timer_fd, int epoll_fd, struct epoll_event *ev, struct epoll_event *events) {
+    uint64_t last_io_ms = monotonic_ms();
+    uint64_t last_pressure_check_ms = 0;
     while (server_running_eb) {
-        int nfds = epoll_wait(epoll_fd, events, MAX_EVENTS, 1000);
+        int busy = monotonic_ms() - last_io_ms < BUSY_WINDOW_MS;
+        int timeout_ms = ready_count > 0 ? 0 : busy ? IDLE_POLL_MS : EPOLL_TIMEOUT_MS;
+        int nfds = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout_ms);
         if (nfds == -1) {
             if (!server_running_eb) break;
             perror("epoll_wait");
             continue;
         }
+
+        uint64_t now_ms = monotonic_ms();
+        if (now_ms - last_pressure_check_ms >= MEMORY_PRESSURE_CHECK_MS) {
+            v8_check_memory_pressure(engine);
+            last_pressure_check_ms = now_ms;
+        }
+        if (nfds == 0 && ready_count == 0) {
+            v8_run_idle_tasks(engine, (busy ? IDLE_GC_BUDGET_MS : IDLE_GC_LONG_BUDGET_MS) / 1000.0);
+        } else {
+            last_io_ms = now_ms;
+        }
         for (int n = 0; n < nfds; ++n) {
             if (events[n].data.fd == timer_fd) {
                 handle_timer_event(engine);
@@ -621,10 +1845,37 @@ static void event_loop(V8Engine *engine, int server_fd, int timer_fd, int epoll_
                 handle_client_event(engine, events[n].data.fd, ev, epoll_fd);
             }
         }
+        serve_ready_connections(engine, epoll_fd, ev);
+        // ::: Under ASP.createBatchServer, the requests this round read go to the handler together.
+        flush_batch(engine);
+        // ::: One microtask checkpoint per iteration: promises chained by this round's handlers and timers
+        // --- settle here, and parked connections get their responses written.
+        v8_run_microtasks(engine);
+        // ::: Anything above may have added or cancelled timers.
+        update_timer_fd();
     }
 }
 
 
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4
+ *
+ * One event loop with everything it owns: its isolate, plus (thread-locally) its listening socket, timerfd,
+ * epoll fd, timer wheel and connections. Reactor 0 is the primary engine on the calling thread; the others
+ * run worker isolates on their own threads.
+ */
+typedef struct {
+    V8Engine *engine;
+    int port;
+    int index;
+    pthread_t thread;
+} Reactor;
+
 /*
   *************************************************************
   *                                                           *
@@ -635,23 +1886,85 @@ static void event_loop(V8Engine *engine, int server_fd, int timer_fd, int epoll_
   *   ██║  ██║███████║██║                                     *
   *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
   *                                                           *
-  * Server startup                                            *
+  * Sets up one reactor's file descriptors and runs its loop  *
+  * until the server stops. Returns 0, or 1 if the setup      *
+  * failed.                                                   *
   *************************************************************
 */
-int start_server_eb(V8Engine *engine, int port) {
-    telemetry_init();
+static int run_reactor(void *data) {
+    Reactor *reactor = data;
     timer_fd = setup_timer_fd();
     if (timer_fd == -1) return 1;
-    int server_fd = setup_server_fd(port);
+    int server_fd = setup_server_fd(reactor->port);
     server_fd_global_eb = server_fd;
     if (server_fd < 0) return 1;
     struct epoll_event ev, events[MAX_EVENTS];
     int epoll_fd = setup_epoll_fd(server_fd, timer_fd, &ev, events);
     if (epoll_fd == -1) return 1;
-    event_loop(engine, server_fd, timer_fd, epoll_fd, &ev, events);
+    event_loop(reactor->engine, server_fd, timer_fd, epoll_fd, &ev, events);
+    cancel_all_js_timers();
     if (timer_fd != -1) close(timer_fd);
     if (server_fd != -1) close(server_fd);
     if (epoll_fd != -1) close(epoll_fd);
-    printf("Event-based server stopped.\n");
     return 0;
 }
+
+static void *reactor_thread(void *data) {
+    Reactor *reactor = data;
+    // ::: Worker isolates are only entered under a Locker. This reactor is the only thread that ever uses its
+    // --- isolate, so the lock is taken once for the loop's whole lifetime and never contended.
+    if (invoke_with_v8_locker(reactor->engine, run_reactor, reactor) != 0)
+        fprintf(stderr, "Reactor %d failed to start\n", reactor->index);
+    return NULL;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Server startup. With { reactors: N } the primary isolate  *
+  * runs reactor 0 here and N - 1 worker isolates run the     *
+  * others, one thread each; without it this is the single    *
+  * event loop.                                               *
+  *************************************************************
+*/
+int start_server_eb(V8Engine *engine, int port) {
+    telemetry_init();
+    int count = v8_get_server_options(engine)->reactors;
+    if (count < 1) count = 1;
+    if (count > MAX_REACTORS) count = MAX_REACTORS;
+    reactor_count = count;
+    batch_limit = v8_get_server_options(engine)->batch;
+
+    Reactor reactors[MAX_REACTORS] = { { .engine = engine, .port = port, .index = 0 } };
+    int started = 1;
+    for (; started < count; started++) {
+        Reactor *reactor = &reactors[started];
+        *reactor = (Reactor){ .engine = v8_create_worker_engine(engine), .port = port, .index = started };
+        if (!reactor->engine) {
+            fprintf(stderr, "Failed to create isolate for reactor %d\n", started);
+            break;
+        }
+        if (pthread_create(&reactor->thread, NULL, reactor_thread, reactor) != 0) {
+            perror("pthread_create");
+            v8_destroy_worker_engine(reactor->engine);
+            break;
+        }
+    }
+    if (started > 1) dprint("Started %d event loop reactors", started);
+
+    int rc = run_reactor(&reactors[0]);
+    server_running_eb = 0;
+    for (int i = 1; i < started; i++) {
+        pthread_join(reactors[i].thread, NULL);
+        v8_destroy_worker_engine(reactors[i].engine);
+    }
+    printf("Event-based server stopped.\n");
+    return rc;
+}
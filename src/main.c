@@ -26,12 +26,22 @@
 
 #include "v8_api_access.h"
 #include <bits/signum-generic.h>
+#include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "utils.h"
 
+// ::: Prefork mode (--workers=N): the number of worker processes, and the supervisor's stop request.
+static int prefork_workers = 0;
+static volatile sig_atomic_t prefork_stopping = 0;
+
 
 
 
@@ -93,6 +103,9 @@ static void install_signal_handlers(void)
    sigaction(SIGINT, &sa, NULL);
    sigaction(SIGTERM, &sa, NULL);
    sigaction(SIGHUP, &sa, NULL);
+   // ::: sendfile has no MSG_NOSIGNAL, so a client that hangs up mid-file would otherwise kill the process.
+   sa.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &sa, NULL);
 }
 
 
@@ -114,29 +127,16 @@ static void install_signal_handlers(void)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Init and boilerplate                                      *
+ * Reads a whole script file into a NUL-terminated, malloc'd *
+ * buffer. Returns NULL on failure.                          *
  *************************************************************
  */
-int main(int argc, char* argv[])
+static char* read_script(const char* path)
 {
-   if (argc < 2) {
-      fprintf(stderr, "Usage: %s <script.js>\n", argv[0]);
-      return 1;
-   }
-
-   // ::: Initializing V8
-   V8Engine* engine = v8_initialize(argc, argv);
-   if (!engine) {
-      fprintf(stderr, "Failed to initialize V8\n");
-      return 1;
-   }
-
-   // ::: Opening the Javascript File
-   FILE* f = fopen(argv[1], "rb");
+   FILE* f = fopen(path, "rb");
    if (!f) {
-      fprintf(stderr, "Could not open script file: %s\n", argv[1]);
-      v8_cleanup(engine);
-      return 1;
+      fprintf(stderr, "Could not open script file: %s\n", path);
+      return NULL;
    }
 
    // ::: Reading the entirety of it into script
@@ -144,19 +144,465 @@ int main(int argc, char* argv[])
    long len = ftell(f);
    fseek(f, 0, SEEK_SET);
    char* script = (char*)malloc(len + 1);
-   fread(script, 1, len, f);
+   if (!script || fread(script, 1, len, f) != (size_t)len) {
+      fprintf(stderr, "Could not read script file: %s\n", path);
+      free(script);
+      fclose(f);
+      return NULL;
+   }
    script[len] = '\0';
    fclose(f);
+   return script;
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Consumes the engine options (heap sizes, request budget,  *
+ * GC profile, raw V8 flags, debug endpoints, prefork       *
+ * workers) wherever they appear and removes them from argv. *
+ * Returns the new argc, or -1 on a malformed option.        *
+ *************************************************************
+ */
+static int parse_engine_options(int argc, char* argv[], V8EngineConfig* config)
+{
+   static const struct
+   {
+      const char* prefix;
+      size_t offset;
+   } size_options[] = {
+      {"--initial-heap-mb=", offsetof(V8EngineConfig, initial_heap_mb)},
+      {"--max-heap-mb=", offsetof(V8EngineConfig, max_heap_mb)},
+      {"--young-gen-mb=", offsetof(V8EngineConfig, young_gen_mb)},
+      {"--old-gen-mb=", offsetof(V8EngineConfig, old_gen_mb)},
+      {"--rss-pressure-mb=", offsetof(V8EngineConfig, rss_pressure_mb)},
+      {"--request-budget-ms=", offsetof(V8EngineConfig, request_budget_ms)},
+   };
+
+   int out = 1;
+   for (int i = 1; i < argc; i++) {
+      const char* arg = argv[i];
+      int consumed = 0;
+      for (size_t o = 0; o < sizeof(size_options) / sizeof(size_options[0]); o++) {
+         size_t prefix_len = strlen(size_options[o].prefix);
+         if (strncmp(arg, size_options[o].prefix, prefix_len) != 0)
+            continue;
+         char* end = NULL;
+         unsigned long long value = strtoull(arg + prefix_len, &end, 10);
+         if (end == arg + prefix_len || *end != '\0') {
+            fprintf(stderr, "Invalid number in %s\n", arg);
+            return -1;
+         }
+         *(size_t*)((char*)config + size_options[o].offset) = (size_t)value;
+         consumed = 1;
+      }
+      if (strncmp(arg, "--gc-profile=", 13) == 0) {
+         config->gc_profile = arg + 13;
+         consumed = 1;
+      } else if (strncmp(arg, "--v8-flags=", 11) == 0) {
+         config->v8_flags = arg + 11;
+         consumed = 1;
+      } else if (strcmp(arg, "--debug-endpoints") == 0) {
+         debug_endpoints_enabled = 1;
+         consumed = 1;
+      } else if (strncmp(arg, "--workers=", 10) == 0) {
+         prefork_workers = atoi(arg + 10);
+         if (prefork_workers < 1) {
+            fprintf(stderr, "Invalid worker count in %s\n", arg);
+            return -1;
+         }
+         consumed = 1;
+      }
+      if (!consumed)
+         argv[out++] = argv[i];
+   }
+   argv[out] = NULL;
+   return out;
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Prints the supported command lines.                       *
+ *************************************************************
+ */
+static void usage(const char* prog)
+{
+   fprintf(stderr,
+           "Usage: %s [engine options] <script.js>\n"
+           "       %s [engine options] --build-snapshot <out.snapshot> <script.js>\n"
+           "       %s [engine options] --snapshot <app.snapshot>\n"
+           "Engine options:\n"
+           "  --max-heap-mb=N --initial-heap-mb=N --young-gen-mb=N --old-gen-mb=N\n"
+           "  --rss-pressure-mb=N (notify V8 of memory pressure above this RSS)\n"
+           "  --request-budget-ms=N (terminate handlers running longer, answer 503)\n"
+           "  --gc-profile=low-latency|throughput|small-footprint\n"
+           "  --v8-flags=\"<raw V8 flags>\"\n"
+           "  --debug-endpoints (serve /debug/profile, /debug/heap and /debug/heap-sampling from the\n"
+           "                     event-based server)\n"
+           "  --workers=N (prefork N server processes sharing the port through SO_REUSEPORT)\n",
+           prog,
+           prog,
+           prog);
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Stop request for the prefork supervisor. Deliberately not *
+ * SA_RESTART, so its waitpid returns.                       *
+ *************************************************************
+ */
+static void handle_prefork_stop(int sig)
+{
+   (void)sig;
+   prefork_stopping = 1;
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Runs the app script once in a throwaway child and writes  *
+ * the initialized heap to `path`. V8 cannot be used across  *
+ * fork(), so the supervisor itself never initializes it.    *
+ * Returns 0 on success.                                     *
+ *************************************************************
+ */
+static int build_prefork_snapshot(int argc, char* argv[], const char* script_path, const char* path)
+{
+   pid_t pid = fork();
+   if (pid < 0) {
+      perror("fork");
+      return -1;
+   }
+   if (pid == 0) {
+      char* script = read_script(script_path);
+      _exit(script && v8_build_snapshot(argc, argv, script, path) == 0 ? 0 : 1);
+   }
+   int status = 0;
+   while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+      ;
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Forks worker `index`: it counts into its own telemetry    *
+ * block, restores its isolate from the snapshot and runs    *
+ * the server loop the script asked for on the shared port.  *
+ * Returns the child's pid, or -1.                           *
+ *************************************************************
+ */
+static pid_t spawn_prefork_worker(int argc, char* argv[], const char* snapshot_path, int index)
+{
+   pid_t pid = fork();
+   if (pid != 0) {
+      if (pid < 0)
+         perror("fork");
+      return pid;
+   }
+
+   // ::: Die with the supervisor instead of holding the port as an orphan.
+   prctl(PR_SET_PDEATHSIG, SIGTERM);
+   if (getppid() == 1)
+      _exit(1);
+   install_signal_handlers();
+   telemetry_select_worker(index);
+   V8Engine* engine = v8_initialize_from_snapshot(argc, argv, snapshot_path);
+   if (!engine) {
+      fprintf(stderr, "Worker %d: failed to initialize V8 from snapshot\n", index);
+      _exit(1);
+   }
+   start_server(engine);
+   v8_cleanup(engine);
+   _exit(0);
+}
+
+
+
+
+
+
+
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Prefork launcher: builds (or takes) the app snapshot,     *
+ * forks the workers and supervises them. A worker that dies *
+ * is restarted in its slot, after a pause if it did not     *
+ * even survive a second. SIGINT/SIGTERM stop all workers;   *
+ * the aggregated telemetry is printed on the way out.       *
+ *************************************************************
+ */
+static int run_prefork(int argc, char* argv[], int workers)
+{
+   char snapshot_path[] = "/tmp/asp-prefork-XXXXXX";
+   const char* path = snapshot_path;
+   int owns_snapshot = 0;
+   if (strcmp(argv[1], "--snapshot") == 0) {
+      if (argc < 3) {
+         usage(argv[0]);
+         return 1;
+      }
+      path = argv[2];
+   } else {
+      int fd = mkstemp(snapshot_path);
+      if (fd < 0) {
+         perror("mkstemp");
+         return 1;
+      }
+      close(fd);
+      owns_snapshot = 1;
+      if (build_prefork_snapshot(argc, argv, argv[1], snapshot_path) != 0) {
+         fprintf(stderr, "Failed to build the prefork snapshot\n");
+         unlink(snapshot_path);
+         return 1;
+      }
+   }
+
+   if (telemetry_share(workers) != 0)
+      return 1;
+   telemetry_init();
+   server_reuse_port = 1;
+
+   struct sigaction sa = {0};
+   sa.sa_handler = handle_prefork_stop;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+   sigaction(SIGHUP, &sa, NULL);
+
+   pid_t* pids = calloc((size_t)workers, sizeof(*pids));
+   time_t* started = calloc((size_t)workers, sizeof(*started));
+   if (!pids || !started) {
+      free(pids);
+      free(started);
+      return 1;
+   }
+   for (int i = 0; i < workers; i++) {
+      pids[i] = spawn_prefork_worker(argc, argv, path, i);
+      started[i] = time(NULL);
+   }
+   printf("Prefork supervisor %d running %d workers\n", (int)getpid(), workers);
+
+   while (!prefork_stopping) {
+      int status = 0;
+      pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0) {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+      int index = -1;
+      for (int i = 0; i < workers; i++) {
+         if (pids[i] == pid)
+            index = i;
+      }
+      if (index < 0 || prefork_stopping)
+         continue;
+      if (WIFSIGNALED(status))
+         fprintf(stderr, "Worker %d (pid %d) killed by signal %d, restarting\n", index, (int)pid,
+                 WTERMSIG(status));
+      else
+         fprintf(stderr, "Worker %d (pid %d) exited with %d, restarting\n", index, (int)pid,
+                 WEXITSTATUS(status));
+      if (time(NULL) - started[index] < 1)
+         sleep(1);
+      pids[index] = spawn_prefork_worker(argc, argv, path, index);
+      started[index] = time(NULL);
+   }
+
+   for (int i = 0; i < workers; i++) {
+      if (pids[i] > 0)
+         kill(pids[i], SIGTERM);
+   }
+   for (int i = 0; i < workers; i++) {
+      if (pids[i] > 0)
+         while (waitpid(pids[i], NULL, 0) < 0 && errno == EINTR)
+            ;
+   }
+   printf("\nPrefork shutdown: %d requests, %d responses 200, %d timeouts over %d workers\n",
+          telemetry_get_request_count(),
+          telemetry_get_200_responses(),
+          telemetry_get_timeouts(),
+          workers);
+   free(pids);
+   free(started);
+   if (owns_snapshot)
+      unlink(snapshot_path);
+   return 0;
+}
+
+
+
+
+
 
-   // ::: Executing the script
-   // --- In M1, this eventually calls PrintImpl via the js that's executed
-   //
-   JSResult res = v8_execute_script(engine, script);
 
-   if (res.type == JS_STRING) {
-      free(res.value.str_result);
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Init and boilerplate                                      *
+ *************************************************************
+ */
+int main(int argc, char* argv[])
+{
+   V8EngineConfig config = {0};
+   argc = parse_engine_options(argc, argv, &config);
+   if (argc < 0 || v8_set_engine_config(&config) != 0) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   if (argc < 2) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   // ::: --build-snapshot: run the script once, serialize the initialized heap and exit.
+   if (strcmp(argv[1], "--build-snapshot") == 0) {
+      if (argc < 4) {
+         usage(argv[0]);
+         return 1;
+      }
+      char* script = read_script(argv[3]);
+      if (!script)
+         return 1;
+      int rc = v8_build_snapshot(argc, argv, script, argv[2]);
+      free(script);
+      if (rc == 0)
+         printf("Snapshot written to %s\n", argv[2]);
+      return rc == 0 ? 0 : 1;
+   }
+
+   // ::: --workers=N: this process only supervises; V8 runs in the forked workers.
+   if (prefork_workers > 0)
+      return run_prefork(argc, argv, prefork_workers);
+
+   V8Engine* engine = NULL;
+   if (strcmp(argv[1], "--snapshot") == 0) {
+      // ::: Booting from a snapshot: builtins, app globals and the handler come out of the blob,
+      // --- so there is no script to compile or run.
+      if (argc < 3) {
+         usage(argv[0]);
+         return 1;
+      }
+      engine = v8_initialize_from_snapshot(argc, argv, argv[2]);
+      if (!engine) {
+         fprintf(stderr, "Failed to initialize V8 from snapshot\n");
+         return 1;
+      }
+   } else {
+      // ::: Initializing V8
+      engine = v8_initialize(argc, argv);
+      if (!engine) {
+         fprintf(stderr, "Failed to initialize V8\n");
+         return 1;
+      }
+
+      char* script = read_script(argv[1]);
+      if (!script) {
+         v8_cleanup(engine);
+         return 1;
+      }
+
+      // ::: Executing the script
+      // --- In M1, this eventually calls PrintImpl via the js that's executed
+      //
+      JSResult res = v8_execute_script_cached(engine, script, argv[1]);
+
+      if (res.type == JS_STRING) {
+         free(res.value.str_result);
+      }
+      free(script);
    }
-   free(script);
 
    install_signal_handlers();
 
@@ -0,0 +1,292 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "route_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef enum { NODE_STATIC, NODE_PARAM, NODE_WILDCARD } NodeKind;
+
+struct RouteNode {
+    NodeKind kind;
+    char *label; /* NODE_STATIC: the bytes this edge consumes; otherwise the parameter name */
+    size_t label_len;
+    RouteNode **children; /* Static edges, each starting with a different byte */
+    size_t child_count;
+    RouteNode *param;
+    RouteNode *wildcard;
+    int handlers[ROUTE_METHOD_COUNT]; /* -1 where the method has none */
+};
+
+static const char *const method_names[ROUTE_METHOD_COUNT] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "PATCH", "OPTIONS",
+};
+
+static RouteNode *node_new(NodeKind kind, const char *label, size_t len) {
+    RouteNode *node = calloc(1, sizeof(*node));
+    if (!node) return NULL;
+    node->label = malloc(len + 1);
+    if (!node->label) {
+        free(node);
+        return NULL;
+    }
+    memcpy(node->label, label, len);
+    node->label[len] = '\0';
+    node->label_len = len;
+    node->kind = kind;
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) node->handlers[i] = -1;
+    return node;
+}
+
+static void node_free(RouteNode *node) {
+    if (!node) return;
+    for (size_t i = 0; i < node->child_count; i++) node_free(node->children[i]);
+    free(node->children);
+    node_free(node->param);
+    node_free(node->wildcard);
+    free(node->label);
+    free(node);
+}
+
+static int node_has_handler(const RouteNode *node) {
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (node->handlers[i] >= 0) return 1;
+    }
+    return 0;
+}
+
+static RouteNode **find_edge(const RouteNode *node, char first) {
+    for (size_t i = 0; i < node->child_count; i++) {
+        if (node->children[i]->label[0] == first) return &node->children[i];
+    }
+    return NULL;
+}
+
+static int append_edge(RouteNode *node, RouteNode *child) {
+    RouteNode **children = realloc(node->children, (node->child_count + 1) * sizeof(*children));
+    if (!children) return -1;
+    children[node->child_count++] = child;
+    node->children = children;
+    return 0;
+}
+
+void route_table_init(RouteTable *table) {
+    table->root = NULL;
+    table->count = 0;
+}
+
+void route_table_free(RouteTable *table) {
+    node_free(table->root);
+    route_table_init(table);
+}
+
+int route_method_parse(const char *method, size_t len) {
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (strlen(method_names[i]) == len && strncasecmp(method_names[i], method, len) == 0) return i;
+    }
+    return -1;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Walks the static run `s` down from `node`, sharing        *
+  * existing edges. An edge that matches only partly is split *
+  * in two: a new node takes the shared prefix and the old    *
+  * one keeps the rest below it. Returns the node at the end  *
+  * of the run, or NULL when out of memory.                   *
+  *************************************************************
+*/
+static RouteNode *insert_static(RouteNode *node, const char *s, size_t len) {
+    while (len > 0) {
+        RouteNode **edge = find_edge(node, s[0]);
+        if (!edge) {
+            RouteNode *child = node_new(NODE_STATIC, s, len);
+            if (!child || append_edge(node, child) < 0) {
+                node_free(child);
+                return NULL;
+            }
+            return child;
+        }
+
+        RouteNode *child = *edge;
+        size_t common = 0;
+        while (common < child->label_len && common < len && child->label[common] == s[common]) common++;
+        if (common < child->label_len) {
+            RouteNode *split = node_new(NODE_STATIC, child->label, common);
+            if (!split || append_edge(split, child) < 0) {
+                node_free(split);
+                return NULL;
+            }
+            memmove(child->label, child->label + common, child->label_len - common + 1);
+            child->label_len -= common;
+            *edge = split;
+            child = split;
+        }
+        node = child;
+        s += common;
+        len -= common;
+    }
+    return node;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Adds a pattern: alternating static runs and parameters,   *
+  * each parameter spanning a whole segment. Colons and       *
+  * asterisks are therefore only allowed right after a '/'.   *
+  *************************************************************
+*/
+int route_table_add(RouteTable *table, const char *method, const char *pattern, int handler) {
+    int all_methods = strcmp(method, "*") == 0;
+    int m = all_methods ? 0 : route_method_parse(method, strlen(method));
+    if (m < 0 || pattern[0] != '/' || handler < 0) return -1;
+    if (!table->root && !(table->root = node_new(NODE_STATIC, "", 0))) return -1;
+
+    RouteNode *node = table->root;
+    int params = 0;
+    const char *p = pattern;
+    while (*p) {
+        size_t run = strcspn(p, ":*");
+        if (run > 0 && !(node = insert_static(node, p, run))) return -1;
+        p += run;
+        if (!*p) break;
+        if (p[-1] != '/' || ++params > ROUTE_MAX_PARAMS) return -1;
+
+        int wildcard = *p == '*';
+        size_t name_len = strcspn(p + 1, "/");
+        if (name_len == 0 || (wildcard && p[1 + name_len] != '\0')) return -1;
+        RouteNode **slot = wildcard ? &node->wildcard : &node->param;
+        if (!*slot && !(*slot = node_new(wildcard ? NODE_WILDCARD : NODE_PARAM, p + 1, name_len))) return -1;
+        // ::: One name per position, otherwise a lookup could not tell which one the value belongs to.
+        if ((*slot)->label_len != name_len || memcmp((*slot)->label, p + 1, name_len) != 0) return -1;
+        node = *slot;
+        p += 1 + name_len;
+    }
+
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (all_methods || i == m) node->handlers[i] = handler;
+    }
+    table->count++;
+    return 0;
+}
+
+static int push_param(RouteMatch *match, const RouteNode *node, const char *value, size_t len) {
+    if (match->param_count >= ROUTE_MAX_PARAMS) return 0;
+    match->params[match->param_count++] = (RouteParam){ node->label, value, len };
+    return 1;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Matches the rest of the path below `node`, trying the     *
+  * static edge, then the parameter, then the wildcard.       *
+  * Parameters pushed on a branch that dead-ends are popped   *
+  * again.                                                    *
+  *************************************************************
+*/
+static const RouteNode *match_node(const RouteNode *node, const char *path, size_t len, RouteMatch *match) {
+    if (len == 0 && node_has_handler(node)) return node;
+    int mark = match->param_count;
+
+    RouteNode **edge = len > 0 ? find_edge(node, path[0]) : NULL;
+    if (edge && (*edge)->label_len <= len && memcmp((*edge)->label, path, (*edge)->label_len) == 0) {
+        size_t label_len = (*edge)->label_len;
+        const RouteNode *found = match_node(*edge, path + label_len, len - label_len, match);
+        if (found) return found;
+    }
+    if (node->param && len > 0) {
+        const char *slash = memchr(path, '/', len);
+        size_t segment = slash ? (size_t)(slash - path) : len;
+        if (segment > 0 && push_param(match, node->param, path, segment)) {
+            const RouteNode *found = match_node(node->param, path + segment, len - segment, match);
+            if (found) return found;
+            match->param_count = mark;
+        }
+    }
+    if (node->wildcard && node_has_handler(node->wildcard) && push_param(match, node->wildcard, path, len)) {
+        return node->wildcard;
+    }
+    return NULL;
+}
+
+RouteResult route_table_lookup(const RouteTable *table,
+                               const char *method,
+                               size_t method_len,
+                               const char *path,
+                               size_t path_len,
+                               RouteMatch *match) {
+    match->handler = -1;
+    match->param_count = 0;
+    match->allowed = 0;
+    const RouteNode *node = table->root && path ? match_node(table->root, path, path_len, match) : NULL;
+    if (!node) return ROUTE_NOT_FOUND;
+
+    int m = route_method_parse(method, method_len);
+    if (m == ROUTE_HEAD && node->handlers[ROUTE_HEAD] < 0) m = ROUTE_GET;
+    if (m >= 0 && node->handlers[m] >= 0) {
+        match->handler = node->handlers[m];
+        return ROUTE_FOUND;
+    }
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (node->handlers[i] >= 0) match->allowed |= 1u << i;
+    }
+    if (match->allowed & (1u << ROUTE_GET)) match->allowed |= 1u << ROUTE_HEAD;
+    return ROUTE_METHOD_NOT_ALLOWED;
+}
+
+size_t route_allow_header(unsigned allowed, char *buf, size_t size) {
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (!(allowed & (1u << i))) continue;
+        int n = snprintf(buf + len, size - len, "%s%s", len ? ", " : "", method_names[i]);
+        if (n < 0 || (size_t)n >= size - len) break;
+        len += (size_t)n;
+    }
+    return len;
+}
@@ -0,0 +1,254 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright © 2025 <The VU Amsterdam ASP teaching team>
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+* and associated documentation files (the “Software”), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute,
+* sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+* BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL <The VU Amsterdam ASP teaching team> BE LIABLE FOR ANY CLAIM,
+* DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static void list_init(TimerEntry *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static void list_unlink(TimerEntry *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+static void list_append(TimerEntry *head, TimerEntry *timer) {
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static uint64_t level_shift(int level) {
+    return (uint64_t)level * TIMER_WHEEL_BITS;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Resets the wheel to an empty state at time now_ms.        *
+  *************************************************************
+*/
+void timer_wheel_init(TimerWheel *wheel, uint64_t now_ms) {
+    wheel->now_ms = now_ms;
+    wheel->count = 0;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        wheel->occupied[level] = 0;
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) list_init(&wheel->slots[level][slot]);
+    }
+}
+
+void timer_entry_init(TimerEntry *timer, TimerCallback callback) {
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires_ms = 0;
+    timer->callback = callback;
+}
+
+int timer_entry_pending(const TimerEntry *timer) {
+    return timer->next != NULL;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Links a timer into the slot its expiry falls in: the      *
+  * finest level whose span still covers the distance from    *
+  * now. Timers beyond the last level wait in its farthest    *
+  * slot and are placed again when it comes around.           *
+  *************************************************************
+*/
+static void place_timer(TimerWheel *wheel, TimerEntry *timer) {
+    uint64_t expires = timer->expires_ms;
+    uint64_t delta = expires - wheel->now_ms;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (uint64_t)1 << level_shift(level + 1)) level++;
+    if (delta >= (uint64_t)1 << level_shift(TIMER_WHEEL_LEVELS)) {
+        expires = wheel->now_ms + ((uint64_t)1 << level_shift(TIMER_WHEEL_LEVELS)) - 1;
+    }
+    int slot = (int)((expires >> level_shift(level)) & SLOT_MASK);
+    list_append(&wheel->slots[level][slot], timer);
+    wheel->occupied[level] |= (uint64_t)1 << slot;
+}
+
+static void unlink_timer(TimerWheel *wheel, TimerEntry *timer) {
+    // ::: The list head sits inside the slot array, so an emptied list tells which occupancy bit to clear.
+    TimerEntry *neighbour = timer->next;
+    list_unlink(timer);
+    if (neighbour->next == neighbour) {
+        for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+            TimerEntry *heads = wheel->slots[level];
+            if (neighbour >= heads && neighbour < heads + TIMER_WHEEL_SLOTS) {
+                wheel->occupied[level] &= ~((uint64_t)1 << (neighbour - heads));
+                break;
+            }
+        }
+    }
+}
+
+void timer_wheel_add(TimerWheel *wheel, TimerEntry *timer, uint64_t expires_ms) {
+    if (timer_entry_pending(timer)) {
+        unlink_timer(wheel, timer);
+    } else {
+        wheel->count++;
+    }
+    timer->expires_ms = expires_ms > wheel->now_ms ? expires_ms : wheel->now_ms + 1;
+    place_timer(wheel, timer);
+}
+
+void timer_wheel_cancel(TimerWheel *wheel, TimerEntry *timer) {
+    if (!timer_entry_pending(timer)) return;
+    unlink_timer(wheel, timer);
+    wheel->count--;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Empties one slot into a local list, so that timers added  *
+  * or cancelled while it is being walked do not disturb the  *
+  * walk.                                                     *
+  *************************************************************
+*/
+static void take_slot(TimerWheel *wheel, int level, int slot, TimerEntry *out) {
+    TimerEntry *head = &wheel->slots[level][slot];
+    list_init(out);
+    if (head->next == head) return;
+    out->next = head->next;
+    out->prev = head->prev;
+    out->next->prev = out;
+    out->prev->next = out;
+    list_init(head);
+    wheel->occupied[level] &= ~((uint64_t)1 << slot);
+}
+
+static void cascade(TimerWheel *wheel, int level) {
+    TimerEntry pending;
+    take_slot(wheel, level, (int)((wheel->now_ms >> level_shift(level)) & SLOT_MASK), &pending);
+    while (pending.next != &pending) {
+        TimerEntry *timer = pending.next;
+        list_unlink(timer);
+        place_timer(wheel, timer);
+    }
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Steps the wheel one millisecond at a time, but jumps      *
+  * straight over stretches in which nothing can happen (see  *
+  * timer_wheel_next_expiry). Coarse slots are moved down     *
+  * before the finest slot of the new tick is run.            *
+  *************************************************************
+*/
+size_t timer_wheel_advance(TimerWheel *wheel, uint64_t now_ms, void *ctx) {
+    size_t fired = 0;
+    while (wheel->now_ms < now_ms) {
+        uint64_t next = timer_wheel_next_expiry(wheel);
+        if (next > now_ms) {
+            wheel->now_ms = now_ms;
+            break;
+        }
+        wheel->now_ms = next;
+
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            if ((wheel->now_ms & (((uint64_t)1 << level_shift(level)) - 1)) == 0) cascade(wheel, level);
+        }
+
+        TimerEntry expired;
+        take_slot(wheel, 0, (int)(wheel->now_ms & SLOT_MASK), &expired);
+        while (expired.next != &expired) {
+            TimerEntry *timer = expired.next;
+            list_unlink(timer);
+            wheel->count--;
+            fired++;
+            timer->callback(timer, ctx);
+        }
+    }
+    return fired;
+}
+
+/*
+  *************************************************************
+  *                                                           *
+  *    █████╗ ███████╗██████╗                                 *
+  *   ██╔══██╗██╔════╝██╔══██╗                                *
+  *   ███████║███████╗██████╔╝                                *
+  *   ██╔══██║╚════██║██╔═══╝                                 *
+  *   ██║  ██║███████║██║                                     *
+  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+  *                                                           *
+  * Scans the occupancy bitmaps: the next non-empty slot of   *
+  * level 0 is an exact expiry, that of a coarser level is    *
+  * the tick at which its timers get moved down.              *
+  *************************************************************
+*/
+uint64_t timer_wheel_next_expiry(const TimerWheel *wheel) {
+    if (wheel->count == 0) return UINT64_MAX;
+    uint64_t best = UINT64_MAX;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t occupied = wheel->occupied[level];
+        if (!occupied) continue;
+        uint64_t shift = level_shift(level);
+        uint64_t current = wheel->now_ms >> shift;
+        // ::: Distance (1..SLOTS) from the current slot to the next occupied one; the current slot itself
+        // --- counts as a full turn away, since it has already been handled at this tick.
+        int start = (int)((current + 1) & SLOT_MASK);
+        uint64_t rotated = (occupied >> start) | (start ? occupied << (TIMER_WHEEL_SLOTS - start) : 0);
+        uint64_t distance = (uint64_t)__builtin_ctzll(rotated) + 1;
+        uint64_t at = (current + distance) << shift;
+        if (at < best) best = at;
+    }
+    return best;
+}
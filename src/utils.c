@@ -24,13 +24,22 @@
 
 #include "utils.h"
 
+#include <errno.h>
+#include <poll.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -80,7 +89,7 @@ JSResult v8_execute_script_file(V8Engine* engine, const char* filename)
         return result;
     }
     buffer[size] = '\0';
-    result = v8_execute_script(engine, buffer);
+    result = v8_execute_script_cached(engine, buffer, filename);
     free(buffer);
     return result;
 }
@@ -91,8 +100,22 @@ JSResult v8_execute_script_file(V8Engine* engine, const char* filename)
 
 int server_fd_global = -1;
 volatile sig_atomic_t server_running = 1;
-static int telemetry_request_count = 0;
-static int telemetry_200_responses = 0;
+int debug_endpoints_enabled = 0;
+int server_reuse_port = 0;
+
+// ::: Telemetry counters. A single process counts into telemetry_local; prefork workers each count into their
+// --- own block of a shared mapping set up by the parent before forking, and every reader sums all blocks.
+typedef struct {
+    atomic_int request_count;
+    atomic_int responses_200;
+    atomic_int timeouts;
+} TelemetryCounters;
+
+static TelemetryCounters telemetry_local;
+static TelemetryCounters* telemetry_blocks = &telemetry_local;
+static int telemetry_block_count = 1;
+static TelemetryCounters* telemetry_own = &telemetry_local;
+static struct timespec telemetry_start_time;
 
 /**
  *   __  __
@@ -109,17 +132,64 @@ static int telemetry_200_responses = 0;
  */
 void telemetry_init()
 {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    // ::: Shared blocks start zeroed and are not reset, so a restarted worker keeps its predecessor's counts.
+    if (telemetry_blocks == &telemetry_local) {
+        atomic_store(&telemetry_local.request_count, 0);
+        atomic_store(&telemetry_local.responses_200, 0);
+        atomic_store(&telemetry_local.timeouts, 0);
+    }
+    clock_gettime(CLOCK_REALTIME, &telemetry_start_time);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Moves the telemetry counters into a shared anonymous      *
+ * mapping with one block per worker. Called by the prefork  *
+ * parent before it forks; each worker then picks its block  *
+ * with telemetry_select_worker. Returns 0 or -1.            *
+ *************************************************************
+ */
+int telemetry_share(int workers)
+{
+    size_t size = (size_t)workers * sizeof(TelemetryCounters);
+    TelemetryCounters* blocks = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (blocks == MAP_FAILED) {
+        perror("mmap(telemetry)");
+        return -1;
+    }
+    telemetry_blocks = blocks;
+    telemetry_block_count = workers;
+    telemetry_own = NULL;
+    return 0;
+}
+
+void telemetry_select_worker(int index)
+{
+    telemetry_own = &telemetry_blocks[index];
+}
+
+int telemetry_get_worker_count()
+{
+    return telemetry_block_count;
+}
+
+// ::: Sums one counter over every block (a single one outside prefork mode).
+static int telemetry_sum(size_t offset)
+{
+    int total = 0;
+    for (int i = 0; i < telemetry_block_count; i++) {
+        atomic_int* counter = (atomic_int*)((char*)&telemetry_blocks[i] + offset);
+        total += atomic_load_explicit(counter, memory_order_relaxed);
+    }
+    return total;
 }
 
 /**
@@ -134,17 +204,7 @@ void telemetry_init()
  */
 void telemetry_increment_request_count()
 {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    atomic_fetch_add_explicit(&telemetry_own->request_count, 1, memory_order_relaxed);
 }
 
 /**
@@ -159,18 +219,7 @@ void telemetry_increment_request_count()
  */
 int telemetry_get_request_count()
 {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return 0;
+    return telemetry_sum(offsetof(TelemetryCounters, request_count));
 }
 
 /**
@@ -185,17 +234,7 @@ int telemetry_get_request_count()
  */
 void telemetry_increment_200_responses()
 {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
+    atomic_fetch_add_explicit(&telemetry_own->responses_200, 1, memory_order_relaxed);
 }
 
 /**
@@ -210,18 +249,119 @@ void telemetry_increment_200_responses()
  */
 int telemetry_get_200_responses()
 {
-    /**
-        ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-        ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-        ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-        ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-        ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-        ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-        ━━━━━━━━━━━━━━━━━━━━━
-        ━━━ Your code here...
-        ━━━━━━━━━━━━━━━━━━━━━
-        */
-    return 0;
+    return telemetry_sum(offsetof(TelemetryCounters, responses_200));
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Increments the count of requests whose handler ran past   *
+ * the execution budget.                                     *
+ *************************************************************
+ */
+
+void telemetry_increment_timeouts()
+{
+    atomic_fetch_add_explicit(&telemetry_own->timeouts, 1, memory_order_relaxed);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Retrieves the count of requests answered 503 because      *
+ * their handler was terminated.                             *
+ *************************************************************
+ */
+
+int telemetry_get_timeouts()
+{
+    return telemetry_sum(offsetof(TelemetryCounters, timeouts));
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Returns the time telemetry_init was called.               *
+ *************************************************************
+ */
+void telemetry_get_start_time(struct timespec* out)
+{
+    *out = telemetry_start_time;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Formats the telemetry counters plus the engine's heap and *
+ * GC statistics as a JSON object. Must run on the thread    *
+ * that owns the isolate. In prefork mode the counters are   *
+ * summed over all workers; heap and GC are this worker's.   *
+ * Returns the length written (snprintf semantics).          *
+ *************************************************************
+ */
+int telemetry_format_json(V8Engine* engine, char* buffer, size_t size)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int requests = telemetry_get_request_count();
+
+    JSHeapStats heap = {0};
+    JSGcStats gc = {0};
+    if (engine) {
+        v8_get_heap_stats(engine, &heap);
+        v8_get_gc_stats(engine, &gc);
+    }
+    double gc_total_ms = gc.total_pause_ns / 1e6;
+    return snprintf(buffer,
+                    size,
+                    "{\"requests\": %d, \"responses_200\": %d, \"timeouts\": %d, \"workers\": %d, "
+                    "\"uptime_s\": %ld, "
+                    "\"heap\": {\"used\": %zu, \"total\": %zu, \"physical\": %zu, \"limit\": %zu, "
+                    "\"external\": %zu}, "
+                    "\"gc\": {\"count\": %llu, \"total_ms\": %.3f, \"max_ms\": %.3f, "
+                    "\"per_request_ms\": %.4f}}",
+                    requests,
+                    telemetry_get_200_responses(),
+                    telemetry_get_timeouts(),
+                    telemetry_get_worker_count(),
+                    (long)(now.tv_sec - telemetry_start_time.tv_sec),
+                    heap.used_heap_size,
+                    heap.total_heap_size,
+                    heap.total_physical_size,
+                    heap.heap_size_limit,
+                    heap.external_memory,
+                    gc.count,
+                    gc_total_ms,
+                    gc.max_pause_ns / 1e6,
+                    requests ? gc_total_ms / requests : 0.0);
 }
 
 /*
@@ -256,3 +396,566 @@ void start_server(V8Engine* engine)
         break;
     }
 }
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Reason phrase for an HTTP status code                     *
+ *************************************************************
+ */
+const char* http_status_text(int status)
+{
+    switch (status) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 203: return "Non-Authoritative Information";
+    case 204: return "No Content";
+    case 205: return "Reset Content";
+    case 206: return "Partial Content";
+    case 300: return "Multiple Choices";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 402: return "Payment Required";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 406: return "Not Acceptable";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 410: return "Gone";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    case 417: return "Expectation Failed";
+    case 418: return "I'm a teapot";
+    case 422: return "Unprocessable Content";
+    case 425: return "Too Early";
+    case 426: return "Upgrade Required";
+    case 428: return "Precondition Required";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 451: return "Unavailable For Legal Reasons";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    }
+    // ::: Anything else gets the generic phrase of its class rather than a misleading "OK".
+    switch (status / 100) {
+    case 1: return "Informational";
+    case 2: return "Success";
+    case 3: return "Redirect";
+    case 4: return "Client Error";
+    default: return "Server Error";
+    }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Finds a header (case-insensitive) in a raw header block   *
+ * and returns its trimmed value, or NULL if it is absent.   *
+ *************************************************************
+ */
+const char* http_find_header(const char* head, size_t head_len, const char* name, size_t* value_len)
+{
+    size_t name_len = strlen(name);
+    const char* end = head + head_len;
+    // ::: Skip the request line, headers start after the first line break.
+    const char* line = memchr(head, '\n', head_len);
+    while (line && ++line < end) {
+        const char* eol = memchr(line, '\n', end - line);
+        const char* line_end = eol ? eol : end;
+        if ((size_t)(line_end - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char* value = line + name_len + 1;
+            while (value < line_end && (*value == ' ' || *value == '\t'))
+                value++;
+            const char* value_end = line_end;
+            while (value_end > value && (value_end[-1] == '\r' || value_end[-1] == ' '))
+                value_end--;
+            if (value_len)
+                *value_len = value_end - value;
+            return value;
+        }
+        line = eol;
+    }
+    return NULL;
+}
+
+// ::: A cached open file (see static_file_open); defined here for http_build_response_head.
+struct StaticFile
+{
+    int fd;
+    size_t size;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    uint64_t checked_ms;
+    int refs; /* One for the cache slot, one per response; guarded by static_cache.lock */
+    const char* content_type;
+    char last_modified[32];
+    char path[];
+};
+
+// ::: A CR or LF in a handler's header would end the line early and let it add headers or split the response.
+static int header_field_is_safe(JSSlice field)
+{
+    for (size_t i = 0; i < field.len; i++) {
+        if (field.ptr[i] == '\r' || field.ptr[i] == '\n' || field.ptr[i] == '\0')
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Serializes the status line and headers of a JSResponse.   *
+ * The handler's body is not copied: send it alongside with  *
+ * http_send_response. Only a default error body is appended *
+ * here. A Transfer-Encoding header replaces Content-Length; *
+ * the body then follows as http_send_chunk calls. Handler   *
+ * headers with a CR, LF or NUL in the name or value are     *
+ * dropped. Returns a malloc'd buffer (caller frees) or      *
+ * NULL.                                                     *
+ *************************************************************
+ */
+char* http_build_response_head(const JSResponse* response, int head_only, int keep_alive, size_t* out_len)
+{
+    const char* default_body = NULL;
+    size_t body_len = response->body.len;
+    // ::: Default error bodies, so e.g. a bare { status: 404 } still says something.
+    if (body_len == 0 && !response->file && response->status >= 400) {
+        default_body = http_status_text(response->status);
+        body_len = strlen(default_body);
+    }
+
+    const char* content_type = response->body_is_binary ? "application/octet-stream" : "text/plain";
+    if (response->file) {
+        body_len = response->file->size;
+        content_type = response->file->content_type;
+    }
+    size_t content_type_len = strlen(content_type);
+    size_t capacity = 512 + (default_body ? body_len : 0);
+    int chunked = 0;
+    for (int i = 0; i < response->header_count; i++) {
+        const JSHeader* h = &response->headers[i];
+        if (!header_field_is_safe(h->name) || !header_field_is_safe(h->value))
+            continue;
+        capacity += h->name.len + h->value.len + 4;
+        if (h->name.len == 12 && strncasecmp(h->name.ptr, "Content-Type", 12) == 0) {
+            content_type = h->value.ptr;
+            content_type_len = h->value.len;
+        }
+        if (h->name.len == 17 && strncasecmp(h->name.ptr, "Transfer-Encoding", 17) == 0)
+            chunked = 1;
+    }
+
+    char* buffer = malloc(capacity);
+    if (!buffer)
+        return NULL;
+
+    char date[64];
+    time_t now = time(NULL);
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm_now);
+
+    size_t len = snprintf(buffer,
+                          capacity,
+                          "HTTP/1.1 %d %s\r\n"
+                          "Content-Type: %.*s\r\n"
+                          "Date: %s\r\n"
+                          "Server: asp-v8/1.0\r\n"
+                          "Connection: %s\r\n",
+                          response->status,
+                          http_status_text(response->status),
+                          (int)content_type_len,
+                          content_type,
+                          date,
+                          keep_alive ? "keep-alive" : "close");
+    if (!chunked)
+        len += snprintf(buffer + len, capacity - len, "Content-Length: %zu\r\n", body_len);
+    if (response->file)
+        len += snprintf(buffer + len, capacity - len, "Last-Modified: %s\r\n", response->file->last_modified);
+
+    // ::: Pass the handler's own headers through, except the ones the server is responsible for.
+    static const char* const reserved[] = {"Content-Type", "Content-Length", "Date", "Server", "Connection"};
+    for (int i = 0; i < response->header_count; i++) {
+        const JSHeader* h = &response->headers[i];
+        int skip = !header_field_is_safe(h->name) || !header_field_is_safe(h->value);
+        for (size_t r = 0; r < sizeof(reserved) / sizeof(reserved[0]); r++) {
+            if (h->name.len == strlen(reserved[r]) && strncasecmp(h->name.ptr, reserved[r], h->name.len) == 0)
+                skip = 1;
+        }
+        if (skip)
+            continue;
+        len += snprintf(buffer + len,
+                        capacity - len,
+                        "%.*s: %.*s\r\n",
+                        (int)h->name.len,
+                        h->name.ptr,
+                        (int)h->value.len,
+                        h->value.ptr);
+    }
+    memcpy(buffer + len, "\r\n", 2);
+    len += 2;
+
+    if (!head_only && default_body) {
+        memcpy(buffer + len, default_body, body_len);
+        len += body_len;
+    }
+    *out_len = len;
+    return buffer;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Writes head and body with one gathered send per attempt,  *
+ * so the body goes out straight from wherever it lives.     *
+ * Never waits: `*sent` counts the bytes of head and body    *
+ * already out, and a later call picks up from there. 0 once *
+ * everything is sent, 1 when the socket is full (wait for   *
+ * it to be writable and call again), -1 on error.           *
+ *************************************************************
+ */
+int http_send_response_partial(int fd, const char* head, size_t head_len, JSSlice body, size_t* sent)
+{
+    size_t body_len = body.ptr ? body.len : 0;
+    while (*sent < head_len + body_len) {
+        struct iovec iov[2];
+        int count = 0;
+        if (*sent < head_len)
+            iov[count++] = (struct iovec){.iov_base = (char*)head + *sent, .iov_len = head_len - *sent};
+        size_t body_sent = *sent > head_len ? *sent - head_len : 0;
+        if (body_sent < body_len)
+            iov[count++] =
+                (struct iovec){.iov_base = (char*)body.ptr + body_sent, .iov_len = body_len - body_sent};
+        // ::: sendmsg is writev with flags, and MSG_NOSIGNAL keeps a vanished client from raising SIGPIPE.
+        struct msghdr msg = {.msg_iov = iov, .msg_iovlen = (size_t)count};
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+        }
+        *sent += (size_t)n;
+    }
+    return 0;
+}
+
+// ::: 0 once `fd` takes more data, -1 if it did not within 5 s.
+static int wait_writable(int fd)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+    return poll(&pfd, 1, 5000) > 0 ? 0 : -1;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Blocking form of http_send_response_partial: waits up to  *
+ * 5 s at a time for POLLOUT on a non-blocking socket. For   *
+ * the thread pool, where a worker owns its connection; the  *
+ * event loop uses the partial form. 0 or -1.                *
+ *************************************************************
+ */
+int http_send_response(int fd, const char* head, size_t head_len, JSSlice body)
+{
+    size_t sent = 0;
+    int rc;
+    while ((rc = http_send_response_partial(fd, head, head_len, body, &sent)) == 1) {
+        if (wait_writable(fd) != 0)
+            return -1;
+    }
+    return rc;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Sends one chunk of a Transfer-Encoding: chunked body; an  *
+ * empty chunk ends the body. 0 or -1, like                  *
+ * http_send_response.                                       *
+ *************************************************************
+ */
+int http_send_chunk(int fd, const char* data, size_t len)
+{
+    if (len == 0)
+        return http_send_response(fd, "0\r\n\r\n", 5, (JSSlice){NULL, 0});
+    char size_line[24];
+    int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+    if (http_send_response(fd, size_line, (size_t)size_len, (JSSlice){data, len}) != 0)
+        return -1;
+    return http_send_response(fd, "\r\n", 2, (JSSlice){NULL, 0});
+}
+
+// ::: Open files are shared by path. A direct-mapped table keeps it bounded: a path that hashes onto a
+// --- taken slot replaces the entry there, which stays open until its last response is sent.
+#define STATIC_CACHE_SLOTS 256
+#define STATIC_CACHE_REVALIDATE_MS 1000
+
+static struct
+{
+    pthread_mutex_t lock;
+    StaticFile* slots[STATIC_CACHE_SLOTS];
+} static_cache = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static const char* content_type_for(const char* path)
+{
+    static const struct
+    {
+        const char* ext;
+        const char* type;
+    } types[] = {
+        {".html", "text/html; charset=utf-8"},
+        {".htm", "text/html; charset=utf-8"},
+        {".css", "text/css; charset=utf-8"},
+        {".js", "text/javascript; charset=utf-8"},
+        {".mjs", "text/javascript; charset=utf-8"},
+        {".json", "application/json"},
+        {".txt", "text/plain; charset=utf-8"},
+        {".svg", "image/svg+xml"},
+        {".png", "image/png"},
+        {".jpg", "image/jpeg"},
+        {".jpeg", "image/jpeg"},
+        {".gif", "image/gif"},
+        {".webp", "image/webp"},
+        {".ico", "image/x-icon"},
+        {".wasm", "application/wasm"},
+        {".woff2", "font/woff2"},
+        {".pdf", "application/pdf"},
+    };
+    const char* dot = strrchr(path, '.');
+    if (dot && !strchr(dot, '/')) {
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+            if (strcasecmp(dot, types[i].ext) == 0)
+                return types[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+static uint64_t static_cache_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static int static_file_matches(const StaticFile* file, const struct stat* st)
+{
+    return file->dev == st->st_dev && file->ino == st->st_ino && file->size == (size_t)st->st_size &&
+           file->mtime.tv_sec == st->st_mtim.tv_sec && file->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+// ::: Called with static_cache.lock held.
+static void static_file_unref_locked(StaticFile* file)
+{
+    if (file && --file->refs == 0) {
+        close(file->fd);
+        free(file);
+    }
+}
+
+static StaticFile* static_file_load(const char* path, uint64_t now_ms)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    size_t path_len = strlen(path);
+    StaticFile* file = NULL;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || !(file = malloc(sizeof(*file) + path_len + 1))) {
+        close(fd);
+        return NULL;
+    }
+    file->fd = fd;
+    file->size = (size_t)st.st_size;
+    file->dev = st.st_dev;
+    file->ino = st.st_ino;
+    file->mtime = st.st_mtim;
+    file->checked_ms = now_ms;
+    file->refs = 1;
+    file->content_type = content_type_for(path);
+    struct tm tm_mtime;
+    gmtime_r(&st.st_mtim.tv_sec, &tm_mtime);
+    strftime(file->last_modified, sizeof(file->last_modified), "%a, %d %b %Y %H:%M:%S GMT", &tm_mtime);
+    memcpy(file->path, path, path_len + 1);
+    return file;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Looks `path` up in the open-file cache. A hit costs a     *
+ * hash and a compare; once a second an entry is checked     *
+ * against stat() and reopened if the file changed. Returns  *
+ * a reference (release with static_file_release), or NULL   *
+ * if `path` is not a readable regular file.                 *
+ *************************************************************
+ */
+StaticFile* static_file_open(const char* path)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* p = path; *p; p++)
+        hash = (hash ^ (unsigned char)*p) * 16777619u;
+    StaticFile** slot = &static_cache.slots[hash % STATIC_CACHE_SLOTS];
+    uint64_t now_ms = static_cache_now_ms();
+
+    pthread_mutex_lock(&static_cache.lock);
+    StaticFile* file = *slot;
+    if (file && strcmp(file->path, path) != 0)
+        file = NULL;
+    if (file && now_ms - file->checked_ms >= STATIC_CACHE_REVALIDATE_MS) {
+        struct stat st;
+        if (stat(path, &st) == 0 && static_file_matches(file, &st)) {
+            file->checked_ms = now_ms;
+        } else {
+            // ::: Changed or gone: drop the entry; responses still sending it keep their own reference.
+            static_file_unref_locked(file);
+            *slot = file = NULL;
+        }
+    }
+    if (!file && (file = static_file_load(path, now_ms))) {
+        static_file_unref_locked(*slot);
+        *slot = file;
+    }
+    if (file)
+        file->refs++;
+    pthread_mutex_unlock(&static_cache.lock);
+    return file;
+}
+
+void static_file_release(StaticFile* file)
+{
+    if (!file)
+        return;
+    pthread_mutex_lock(&static_cache.lock);
+    static_file_unref_locked(file);
+    pthread_mutex_unlock(&static_cache.lock);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Sends a response head followed by a whole cached file.    *
+ * The head goes out with MSG_MORE so it can share a segment *
+ * with the file's first bytes, and the file itself goes     *
+ * from the page cache to the socket with sendfile(2), never *
+ * passing through user space. Never waits; `*sent` and the  *
+ * result work as in http_send_response_partial.             *
+ *************************************************************
+ */
+int http_send_file_partial(int fd, const char* head, size_t head_len, const StaticFile* file, size_t* sent)
+{
+    while (*sent < head_len) {
+        ssize_t n = send(fd, head + *sent, head_len - *sent, MSG_NOSIGNAL | MSG_MORE);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+        }
+        *sent += (size_t)n;
+    }
+
+    // ::: An explicit offset leaves the shared fd's file position alone, so threads can send it at once.
+    while (*sent - head_len < file->size) {
+        off_t offset = (off_t)(*sent - head_len);
+        ssize_t n = sendfile(fd, file->fd, &offset, file->size - (size_t)offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+        }
+        // ::: The file shrank under us; the promised Content-Length can no longer be met.
+        if (n == 0)
+            return -1;
+        *sent += (size_t)n;
+    }
+    return 0;
+}
+
+// ::: Blocking form of http_send_file_partial, like http_send_response. 0 or -1.
+int http_send_file(int fd, const char* head, size_t head_len, const StaticFile* file)
+{
+    size_t sent = 0;
+    int rc;
+    while ((rc = http_send_file_partial(fd, head, head_len, file, &sent)) == 1) {
+        if (wait_writable(fd) != 0)
+            return -1;
+    }
+    return rc;
+}
@@ -23,17 +23,28 @@
  */
 
 #include "v8_api_access.h"
+#include "route_table.h"
 #include "utils.h"
 #include "v8-exception.h"
 #include "v8-local-handle.h"
 #include "v8-primitive.h"
+#include "v8-profiler.h"
 #include "v8-value.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
 #include <libplatform/libplatform.h>
 #include <mutex>
 #include <string>
+#include <sys/stat.h>
 #include <thread>
+#include <time.h>
+#include <unistd.h>
 #include <unordered_map>
 #include <v8.h>
+#include <vector>
 
 typedef struct
 {
@@ -41,6 +52,7 @@ typedef struct
    int port{};
    bool is_set{};
    HTTPServerType server_type = HTTPServerTypeUnknown;
+   ServerOptions options{};
 } ServerHandlerInfo;
 
 /*
@@ -285,7 +297,8 @@ static void register_print_function(v8::Isolate* isolate, v8::Local<v8::Context>
       .Check();
 }
 
-extern "C" void register_js_interval_callback(int ms, JSObject cb);
+extern "C" int register_js_timer(int ms, int repeat, JSObject cb);
+extern "C" void cancel_js_timer(int id);
 
 // ::: Lets C call the C++ functions defined here.
 extern "C" {
@@ -306,17 +319,16 @@ struct JSObjectHandle
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
+ * An app script as run on the primary engine, together with *
+ * the code cache it was compiled with (or produced), so     *
+ * that worker isolates can replay it without compiling from *
+ * scratch.                                                  *
  *************************************************************
  */
-struct V8EngineHandle
+struct AppScript
 {
-   std::unique_ptr<v8::Platform> platform;
-   v8::Isolate* isolate;
-   v8::Global<v8::Context> context;
-   std::unordered_map<std::string, int (*)(int)> registered_functions;
-   ServerHandlerInfo g_server_handler;
-   std::mutex g_handler_mutex;
-   v8::ArrayBuffer::Allocator* array_buffer_allocator;
+   std::string source;
+   std::string code_cache;
 };
 
 /*
@@ -329,25 +341,28 @@ struct V8EngineHandle
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Registers a JS callback and interval in milliseconds for  *
- * future execution.                                         *
+ * Process-wide V8 state. There is exactly one platform per  *
+ * process, shared by every isolate (engine) created on it.  *
  *************************************************************
  */
-void SetIntervalImpl(const v8::FunctionCallbackInfo<v8::Value>& args)
+struct V8PlatformHandle
 {
-   v8::Isolate* isolate = args.GetIsolate();
-   v8::HandleScope handle_scope(isolate);
-   v8::Local<v8::Context> context = isolate->GetCurrentContext();
-   if (args.Length() < 2 || !args[0]->IsFunction() || !args[1]->IsNumber()) {
-      isolate->ThrowException(
-         v8::String::NewFromUtf8(isolate, "setInterval expects (function, ms)").ToLocalChecked());
-      return;
-   }
-   v8::Local<v8::Function> cb = args[0].As<v8::Function>();
-   int ms = args[1]->Int32Value(context).ToChecked();
-
-   register_js_interval_callback(ms, new JSObjectHandle(isolate, args[0].As<v8::Object>()));
-}
+   std::unique_ptr<v8::Platform> platform;
+   std::mutex platform_mutex;
+   // ::: Every script executed on the primary engine, in order. Worker engines replay these so that each
+   // --- isolate ends up with the same globals and its own registered handler.
+   std::vector<AppScript> app_scripts;
+   // ::: Set when booting from a startup snapshot. Every isolate on this platform is then deserialized
+   // --- from it instead of running app_scripts. Owns snapshot.data.
+   v8::StartupData snapshot{nullptr, 0};
+   // ::: Request budget watchdog. Only started when request_budget_ms is set; it polls the engines listed
+   // --- here and terminates whichever has been running JS past its deadline.
+   std::thread watchdog;
+   std::mutex watchdog_mutex;
+   std::condition_variable watchdog_wake;
+   bool watchdog_stop = false;
+   std::vector<V8Engine*> watched_engines;
+};
 
 /*
  *************************************************************
@@ -359,27 +374,41 @@ void SetIntervalImpl(const v8::FunctionCallbackInfo<v8::Value>& args)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Registers a server handler callback and port              *
+ * Property keys the bridge touches on every request. They   *
+ * are internalized once per isolate and kept in Eternals.   *
  *************************************************************
  */
-void RegisterServerCallBack(V8Engine* engine,
-                            v8::Isolate* isolate,
-                            const v8::FunctionCallbackInfo<v8::Value>& args)
+enum EngineKey
 {
-   v8::HandleScope handle_scope(isolate);
-   v8::Local<v8::Context> context = isolate->GetCurrentContext();
-   if (args.Length() < 2 || !args[0]->IsFunction() || !args[1]->IsNumber()) {
-      isolate->ThrowException(
-         v8::String::NewFromUtf8(isolate, "createServer expects (function, port)").ToLocalChecked());
-      return;
-   }
-   std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+   KEY_METHOD,
+   KEY_PATH,
+   KEY_BODY,
+   KEY_SIZE,
+   KEY_HEADERS,
+   KEY_BODY_BUFFER,
+   KEY_STATUS,
+   KEY_CONTENT_TYPE,
+   KEY_JSON,
+   KEY_JSON_MIME,
+   KEY_QUERY,
+   KEY_PARAMS,
+   KEY_FILE,
+   KEY_COUNT
+};
 
-   engine->g_server_handler.handler = new JSObjectHandle(isolate, args[0].As<v8::Object>());
-   engine->g_server_handler.port = args[1]->Int32Value(context).ToChecked();
-   engine->g_server_handler.is_set = true;
-   engine->g_server_handler.server_type = HTTPServerTypeSingleThreaded;
-}
+static const char* const engine_key_names[KEY_COUNT] = {"method",
+                                                        "path",
+                                                        "body",
+                                                        "size",
+                                                        "headers",
+                                                        "bodyBuffer",
+                                                        "status",
+                                                        "Content-Type",
+                                                        "json",
+                                                        "application/json",
+                                                        "query",
+                                                        "params",
+                                                        "file"};
 
 /*
  *************************************************************
@@ -391,16 +420,82 @@ void RegisterServerCallBack(V8Engine* engine,
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Sets up a single-threaded server handler in the engine    *
+ * Per-isolate state. One of these exists for the primary    *
+ * isolate, plus one per worker in isolate-per-worker mode.  *
  *************************************************************
  */
-void CreateServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+struct RequestBodyOwner;
+
+// ::: One parked handler promise, kept in the engine's table under its token.
+struct PendingDispatch
 {
-   v8::Isolate* isolate = args.GetIsolate();
-   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
-   RegisterServerCallBack(engine, isolate, args);
-   engine->g_server_handler.server_type = HTTPServerTypeSingleThreaded;
-}
+   JSResponseCallback callback;
+   void* ctx;
+};
+
+struct V8EngineHandle
+{
+   V8PlatformHandle* shared;
+   bool is_primary;
+   v8::Isolate* isolate;
+   v8::Global<v8::Context> context;
+   std::unordered_map<std::string, int (*)(int)> registered_functions;
+   ServerHandlerInfo g_server_handler;
+   std::mutex g_handler_mutex;
+   // ::: ASP.route registrations. The trie maps (method, path) to an index into route_handlers; route_specs
+   // --- keeps the (method, pattern) of each so a snapshot can register them again.
+   RouteTable routes{};
+   std::vector<v8::Global<v8::Function>> route_handlers;
+   std::vector<std::pair<std::string, std::string>> route_specs;
+   // ::: ASP.static mounts as (URL prefix, directory), checked in order before the route table.
+   std::vector<std::pair<std::string, std::string>> static_mounts;
+   v8::ArrayBuffer::Allocator* array_buffer_allocator;
+   v8::Eternal<v8::String> keys[KEY_COUNT];
+   // ::: Every request object is stamped from this template, so they all share one hidden class.
+   v8::Eternal<v8::ObjectTemplate> request_template;
+   // ::: Backs request.headers: a named-property interceptor over the C-side header slices.
+   v8::Eternal<v8::ObjectTemplate> headers_template;
+   // ::: The request the handler is running for. Lazy request fields read from it until the dispatch
+   // --- returns; request_generation is stamped into every request object, so a stale one reads nothing.
+   JSRequest* active_request = nullptr;
+   RequestBodyOwner* active_body = nullptr;
+   int32_t request_generation = 0;
+   // ::: Only while running the app script under a SnapshotCreator: setInterval/setTimeout park their
+   // --- callbacks here instead of arming event loop timers, so they can be written into the snapshot.
+   bool building_snapshot = false;
+   // ::: While a worker replays the app script. That runs on the thread creating the worker, whose event
+   // --- loop (if any) belongs to another isolate, so the script's own timers are left to the primary.
+   bool replaying = false;
+   struct SnapshotTimer
+   {
+      v8::Global<v8::Function> callback;
+      int ms;
+      bool repeat;
+   };
+   std::vector<SnapshotTimer> snapshot_timers;
+   // ::: GC pause accounting. gc_start_ns is only touched on the isolate's thread; the totals are read
+   // --- by telemetry from other threads.
+   uint64_t gc_start_ns = 0;
+   std::atomic<uint64_t> gc_count{0};
+   std::atomic<uint64_t> gc_pause_ns{0};
+   std::atomic<uint64_t> gc_max_pause_ns{0};
+   // ::: Last level passed to MemoryPressureNotification, so only changes are forwarded.
+   JSMemoryPressure memory_pressure = JS_MEMORY_PRESSURE_NONE;
+   // ::: Execution budget. budget_deadline_ns is 0 while no budgeted JS runs. Both fields are guarded by
+   // --- budget_mutex, so the watchdog can never terminate a run that has already been disarmed.
+   std::mutex budget_mutex;
+   uint64_t budget_deadline_ns = 0;
+   bool budget_expired = false;
+   // ::: Created on the first /debug/profile request and kept for the isolate's lifetime; profiling is true
+   // --- between v8_cpu_profile_start and v8_cpu_profile_stop.
+   v8::CpuProfiler* cpu_profiler = nullptr;
+   bool profiling = false;
+   bool heap_sampling = false;
+   // ::: Parked handler promises by token. Both reactions carry the token, not a pointer: whichever runs
+   // --- first takes the entry out, and one whose dispatch was cancelled (or already settled) finds nothing.
+   std::unordered_map<uint64_t, PendingDispatch> pending_dispatches;
+   uint64_t next_dispatch_token = 0;
+};
 
 /*
  *************************************************************
@@ -412,15 +507,12 @@ void CreateServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Sets up a thread pool server handler in the engine.       *
+ * Returns one of the pre-internalized keys.                 *
  *************************************************************
  */
-void CreateThreadPoolServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+static inline v8::Local<v8::String> engine_key(V8Engine* engine, EngineKey key)
 {
-   v8::Isolate* isolate = args.GetIsolate();
-   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
-   RegisterServerCallBack(engine, isolate, args);
-   engine->g_server_handler.server_type = HTTPServerTypeThreadPool;
+   return engine->keys[key].Get(engine->isolate);
 }
 
 /*
@@ -433,17 +525,29 @@ void CreateThreadPoolServerCallback(const v8::FunctionCallbackInfo<v8::Value>& a
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Sets up an event loop server handler in the engine.       *
+ * Resolves a property name coming from C. Known keys come   *
+ * from the Eternal table, anything else is internalized.    *
  *************************************************************
  */
-void CreateEventLoopServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+static v8::Local<v8::String> property_key(V8Engine* engine, const char* key)
 {
-   v8::Isolate* isolate = args.GetIsolate();
-   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
-   RegisterServerCallBack(engine, isolate, args);
-   engine->g_server_handler.server_type = HTTPServerTypeEventLoop;
+   for (int i = 0; i < KEY_COUNT; i++) {
+      if (strcmp(engine_key_names[i], key) == 0)
+         return engine_key(engine, (EngineKey)i);
+   }
+   return v8::String::NewFromUtf8(engine->isolate, key, v8::NewStringType::kInternalized).ToLocalChecked();
 }
 
+// ::: Lazy request fields and the header interceptor, defined next to build_request_object.
+static void RequestBodyGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info);
+static void RequestBodyBufferGetter(v8::Local<v8::Name> name,
+                                    const v8::PropertyCallbackInfo<v8::Value>& info);
+static void RequestHeadersGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info);
+static void RequestQueryGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info);
+static void RequestHeaderGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info);
+static void RequestHeaderQuery(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Integer>& info);
+static void RequestHeaderEnumerator(const v8::PropertyCallbackInfo<v8::Array>& info);
+
 /*
  *************************************************************
  *                                                           *
@@ -454,37 +558,48 @@ void CreateEventLoopServerCallback(const v8::FunctionCallbackInfo<v8::Value>& ar
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Registers main ASP builtin functions                      *
+ * Fills the key table and builds the request template.      *
+ * Must run inside the isolate and a HandleScope.            *
  *************************************************************
  */
-static void register_asp_object(v8::Isolate* isolate, v8::Local<v8::Context> context)
+static void init_engine_keys(V8Engine* engine)
 {
-   v8::Context::Scope context_scope(context);
-   v8::Local<v8::Object> asp = v8::Object::New(isolate);
-   v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, CreateServerCallback);
-   v8::Local<v8::Function> fn = tpl->GetFunction(context).ToLocalChecked();
-   asp->Set(context, v8::String::NewFromUtf8(isolate, "createServer").ToLocalChecked(), fn).Check();
-   v8::Local<v8::FunctionTemplate> tpl2 = v8::FunctionTemplate::New(isolate, CreateThreadPoolServerCallback);
-   v8::Local<v8::Function> fn2 = tpl2->GetFunction(context).ToLocalChecked();
-   asp->Set(context, v8::String::NewFromUtf8(isolate, "createThreadPoolServer").ToLocalChecked(), fn2)
-      .Check();
-   v8::Local<v8::FunctionTemplate> tpl3 = v8::FunctionTemplate::New(isolate, CreateEventLoopServerCallback);
-   v8::Local<v8::Function> fn3 = tpl3->GetFunction(context).ToLocalChecked();
-   asp->Set(context, v8::String::NewFromUtf8(isolate, "createEventLoopServer").ToLocalChecked(), fn3).Check();
-   v8::Local<v8::FunctionTemplate> setinterval_tpl = v8::FunctionTemplate::New(isolate, SetIntervalImpl);
-   v8::Local<v8::Function> setinterval_fn = setinterval_tpl->GetFunction(context).ToLocalChecked();
-   context->Global()
-      ->Set(context, v8::String::NewFromUtf8(isolate, "setInterval").ToLocalChecked(), setinterval_fn)
-      .Check();
-   context->Global()->Set(context, v8::String::NewFromUtf8(isolate, "ASP").ToLocalChecked(), asp).Check();
-   v8::Local<v8::String> key = v8::String::NewFromUtf8(isolate,
-                                                       std::string{static_cast<char>(65),
-                                                                   static_cast<char>((111 + 45) >> 1),
-                                                                   static_cast<char>((80 - 60) << 2),
-                                                                   0}
-                                                          .c_str())
-                                  .ToLocalChecked();
-   context->Global()->Set(context, key, asp).Check();
+   v8::Isolate* isolate = engine->isolate;
+   for (int i = 0; i < KEY_COUNT; i++) {
+      v8::Local<v8::String> key =
+         v8::String::NewFromUtf8(isolate, engine_key_names[i], v8::NewStringType::kInternalized)
+            .ToLocalChecked();
+      engine->keys[i].Set(isolate, key);
+   }
+
+   // ::: Declaring every field up front fixes the property order, so every instance starts on the same map
+   // --- and the handler's loads stay monomorphic. Only method, path and size are filled in per request;
+   // --- the rest are lazy and become V8 values on first access.
+   v8::Local<v8::ObjectTemplate> tmpl = v8::ObjectTemplate::New(isolate);
+   tmpl->SetInternalFieldCount(1);
+   tmpl->Set(engine_key(engine, KEY_METHOD), v8::Undefined(isolate));
+   tmpl->Set(engine_key(engine, KEY_PATH), v8::Undefined(isolate));
+   tmpl->SetLazyDataProperty(engine_key(engine, KEY_BODY), RequestBodyGetter);
+   tmpl->Set(engine_key(engine, KEY_SIZE), v8::Undefined(isolate));
+   tmpl->SetLazyDataProperty(engine_key(engine, KEY_HEADERS), RequestHeadersGetter);
+   tmpl->SetLazyDataProperty(engine_key(engine, KEY_BODY_BUFFER), RequestBodyBufferGetter);
+   tmpl->SetLazyDataProperty(engine_key(engine, KEY_QUERY), RequestQueryGetter);
+   tmpl->Set(engine_key(engine, KEY_PARAMS), v8::Undefined(isolate));
+   engine->request_template.Set(isolate, tmpl);
+
+   // ::: kNonMasking lets own properties win, which is how materialize_request freezes the headers.
+   v8::Local<v8::ObjectTemplate> headers = v8::ObjectTemplate::New(isolate);
+   headers->SetInternalFieldCount(1);
+   int flags = static_cast<int>(v8::PropertyHandlerFlags::kNonMasking) |
+               static_cast<int>(v8::PropertyHandlerFlags::kOnlyInterceptStrings);
+   headers->SetHandler(v8::NamedPropertyHandlerConfiguration(RequestHeaderGetter,
+                                                             nullptr,
+                                                             RequestHeaderQuery,
+                                                             nullptr,
+                                                             RequestHeaderEnumerator,
+                                                             v8::Local<v8::Value>(),
+                                                             static_cast<v8::PropertyHandlerFlags>(flags)));
+   engine->headers_template.Set(isolate, headers);
 }
 
 /*
@@ -497,31 +612,47 @@ static void register_asp_object(v8::Isolate* isolate, v8::Local<v8::Context> con
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Initializes the V8 engine and context                     *
+ * Shared body of setInterval and setTimeout: registers the  *
+ * callback with the event loop's timer wheel and returns    *
+ * the timer id. Timers go into the calling thread's wheel.  *
+ * The app script's own timers run on the primary only: a    *
+ * worker isolate replaying the script gets 0 and no timer,  *
+ * but once it serves requests on its reactor, its handlers  *
+ * arm timers in that reactor's wheel.                       *
  *************************************************************
  */
-V8Engine* v8_initialize(int argc, char* argv[])
+static void add_js_timer(const v8::FunctionCallbackInfo<v8::Value>& args, bool repeat)
 {
-   auto* engine = new V8Engine();
-   v8::V8::InitializeICUDefaultLocation(argv[0]);
-   v8::V8::InitializeExternalStartupData(argv[0]);
-   engine->platform = v8::platform::NewDefaultPlatform();
-   v8::V8::InitializePlatform(engine->platform.get());
-   v8::V8::Initialize();
-   v8::Isolate::CreateParams create_params;
-   create_params.array_buffer_allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
-   engine->array_buffer_allocator = create_params.array_buffer_allocator;
-   engine->isolate = v8::Isolate::New(create_params);
-   engine->isolate->SetData(0, engine);
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Context::New(engine->isolate);
-   engine->context.Reset(engine->isolate, local_context);
-   register_print_function(engine->isolate, local_context);
-   register_asp_object(engine->isolate, local_context);
-   return engine;
+   v8::Isolate* isolate = args.GetIsolate();
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = isolate->GetCurrentContext();
+   if (args.Length() < 1 || !args[0]->IsFunction()) {
+      isolate->ThrowException(v8::String::NewFromUtf8(isolate,
+                                                      repeat ? "setInterval expects (function, ms)"
+                                                             : "setTimeout expects (function, ms)")
+                                 .ToLocalChecked());
+      return;
+   }
+   v8::Local<v8::Function> cb = args[0].As<v8::Function>();
+   int ms = args.Length() > 1 ? args[1]->Int32Value(context).FromMaybe(0) : 0;
+
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   if (engine && engine->building_snapshot) {
+      engine->snapshot_timers.push_back({v8::Global<v8::Function>(isolate, cb), ms, repeat});
+      args.GetReturnValue().Set((int)engine->snapshot_timers.size());
+      return;
+   }
+   if (engine && engine->replaying) {
+      args.GetReturnValue().Set(0);
+      return;
+   }
+   args.GetReturnValue().Set(register_js_timer(ms, repeat, new JSObjectHandle(isolate, cb.As<v8::Object>())));
 }
 
+void SetIntervalImpl(const v8::FunctionCallbackInfo<v8::Value>& args) { add_js_timer(args, true); }
+
+void SetTimeoutImpl(const v8::FunctionCallbackInfo<v8::Value>& args) { add_js_timer(args, false); }
+
 /*
  *************************************************************
  *                                                           *
@@ -532,43 +663,16 @@ V8Engine* v8_initialize(int argc, char* argv[])
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Compiles and executes a JavaScript script using V8        *
+ * clearInterval / clearTimeout. Unknown and already fired   *
+ * ids are ignored.                                          *
  *************************************************************
  */
-JSResult v8_execute_script(V8Engine* engine, const char* script)
+void ClearTimerImpl(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   JSResult result = {0};
-   if (!engine->isolate)
-      return result;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   try {
-      v8::Local<v8::String> source = v8::String::NewFromUtf8(engine->isolate, script).ToLocalChecked();
-      v8::Local<v8::Script> compiled_script = v8::Script::Compile(local_context, source).ToLocalChecked();
-      v8::MaybeLocal<v8::Value> maybe_result = compiled_script->Run(local_context);
-      if (maybe_result.IsEmpty()) {
-         // there was an exception
-         return result;
-      }
-      v8::Local<v8::Value> js_result = maybe_result.ToLocalChecked();
-      if (js_result->IsNumber()) {
-         result.success = 1;
-         result.value.int_result = js_result->Int32Value(local_context).ToChecked();
-      } else if (js_result->IsValue()) {
-         result.success = 1;
-         v8::String::Utf8Value str(engine->isolate, js_result.As<v8::String>());
-         const char* cstr = *str;
-         if (cstr) {
-            result.value.str_result = strdup(cstr);
-            result.type = JS_STRING;
-         }
-      }
-   } catch (...) {
-      result.success = 0;
-   }
-   return result;
+   v8::Isolate* isolate = args.GetIsolate();
+   if (args.Length() < 1 || !args[0]->IsNumber())
+      return;
+   cancel_js_timer(args[0]->Int32Value(isolate->GetCurrentContext()).FromMaybe(0));
 }
 
 /*
@@ -581,28 +685,36 @@ JSResult v8_execute_script(V8Engine* engine, const char* script)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Registers a C function as a global JavaScript function    *
- * in the V8 context.                                        *
+ * Reads a boolean field of the optional server options     *
+ * object, leaving the default untouched when it is absent.  *
  *************************************************************
  */
-int v8_register_function(V8Engine* engine, const char* name, int (*func)(int))
+static void read_bool_option(v8::Isolate* isolate,
+                             v8::Local<v8::Context> context,
+                             v8::Local<v8::Object> options,
+                             const char* key,
+                             int* out)
 {
-   if (!engine->isolate)
-      return 0;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   engine->registered_functions[name] = func;
-   v8::Local<v8::External> func_ptr = v8::External::New(engine->isolate, (void*)func);
-   v8::Local<v8::FunctionTemplate> tpl =
-      v8::FunctionTemplate::New(engine->isolate, CFunctionCallback, func_ptr);
-   local_context->Global()
-      ->Set(local_context,
-            v8::String::NewFromUtf8(engine->isolate, name).ToLocalChecked(),
-            tpl->GetFunction(local_context).ToLocalChecked())
-      .Check();
-   return 1;
+   v8::Local<v8::Value> value;
+   if (!options->Get(context, v8::String::NewFromUtf8(isolate, key).ToLocalChecked()).ToLocal(&value) ||
+       value->IsUndefined()) {
+      return;
+   }
+   *out = value->BooleanValue(isolate) ? 1 : 0;
+}
+
+static void read_int_option(v8::Isolate* isolate,
+                            v8::Local<v8::Context> context,
+                            v8::Local<v8::Object> options,
+                            const char* key,
+                            int* out)
+{
+   v8::Local<v8::Value> value;
+   if (!options->Get(context, v8::String::NewFromUtf8(isolate, key).ToLocalChecked()).ToLocal(&value) ||
+       value->IsUndefined()) {
+      return;
+   }
+   *out = value->Int32Value(context).FromMaybe(0);
 }
 
 /*
@@ -615,22 +727,47 @@ int v8_register_function(V8Engine* engine, const char* name, int (*func)(int))
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Disposes the V8 engine and associated resources.          *
+ * Registers a server handler callback and port              *
  *************************************************************
  */
-void v8_cleanup(V8Engine* engine)
+void RegisterServerCallBack(V8Engine* engine,
+                            v8::Isolate* isolate,
+                            const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   engine->registered_functions.clear();
-   engine->context.Reset();
-   if (engine->isolate) {
-      engine->isolate->Dispose();
-      engine->isolate = nullptr;
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = isolate->GetCurrentContext();
+   if (args.Length() < 2 || !(args[0]->IsFunction() || args[0]->IsNull()) || !args[1]->IsNumber()) {
+      isolate->ThrowException(
+         v8::String::NewFromUtf8(isolate, "createServer expects (function | null, port)").ToLocalChecked());
+      return;
+   }
+   std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+
+   // ::: Registering twice replaces the handler, so let go of the previous one. A null handler serves
+   // --- ASP.route routes only and answers everything else with 404 / 405.
+   v8_free_object(engine->g_server_handler.handler);
+   engine->g_server_handler.handler =
+      args[0]->IsFunction() ? new JSObjectHandle(isolate, args[0].As<v8::Object>()) : nullptr;
+   engine->g_server_handler.port = args[1]->Int32Value(context).ToChecked();
+   engine->g_server_handler.is_set = true;
+   engine->g_server_handler.server_type = HTTPServerTypeSingleThreaded;
+
+   // ::: Optional third argument: { isolatePerWorker: bool, reactors: number, acceptPerWorker: bool, ... }
+   engine->g_server_handler.options = ServerOptions{};
+   if (args.Length() > 2 && args[2]->IsObject()) {
+      v8::Local<v8::Object> options = args[2].As<v8::Object>();
+      read_bool_option(
+         isolate, context, options, "isolatePerWorker", &engine->g_server_handler.options.isolate_per_worker);
+      read_int_option(isolate, context, options, "reactors", &engine->g_server_handler.options.reactors);
+      read_bool_option(
+         isolate, context, options, "acceptPerWorker", &engine->g_server_handler.options.accept_per_worker);
+      read_bool_option(
+         isolate, context, options, "steerToCpu", &engine->g_server_handler.options.steer_to_cpu);
+      read_bool_option(
+         isolate, context, options, "jsExecutor", &engine->g_server_handler.options.js_executor);
+      read_bool_option(
+         isolate, context, options, "keepAlive", &engine->g_server_handler.options.keep_alive);
    }
-   v8::V8::Dispose();
-   v8::V8::DisposePlatform();
-   engine->platform.reset();
-   delete engine->array_buffer_allocator;
-   delete engine;
 }
 
 /*
@@ -643,20 +780,15 @@ void v8_cleanup(V8Engine* engine)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Creates a new JavaScript object                           *
- * and returns a handle to it.                               *
+ * Sets up a single-threaded server handler in the engine    *
  *************************************************************
  */
-JSObjectHandle* v8_create_object(V8Engine* engine)
+void CreateServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   if (!engine->isolate)
-      return nullptr;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   v8::Local<v8::Object> obj = v8::Object::New(engine->isolate);
-   return new JSObjectHandle(engine->isolate, obj);
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   RegisterServerCallBack(engine, isolate, args);
+   engine->g_server_handler.server_type = HTTPServerTypeSingleThreaded;
 }
 
 /*
@@ -669,100 +801,72 @@ JSObjectHandle* v8_create_object(V8Engine* engine)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Sets a string property on a JavaScript object from C      *
+ * Sets up a thread pool server handler in the engine.       *
  *************************************************************
  */
-int v8_set_string_property(V8Engine* engine, JSObjectHandle* obj, const char* key, const char* value)
+void CreateThreadPoolServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   if (!engine->isolate || !obj)
-      return 0;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
-   v8::Maybe<bool> result = js_obj->Set(local_context,
-                                        v8::String::NewFromUtf8(engine->isolate, key).ToLocalChecked(),
-                                        v8::String::NewFromUtf8(engine->isolate, value).ToLocalChecked());
-   if (result.IsNothing() || !result.FromJust()) {
-      return 0;
-   }
-   return 1;
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   RegisterServerCallBack(engine, isolate, args);
+   engine->g_server_handler.server_type = HTTPServerTypeThreadPool;
 }
 
 /*
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3
- *
- *  v8_set_number_property sets a numeric property on a JavaScript object
- * (JSObjectHandle) from C code using the V8 API. The implementation is
- * essentially analogous to v8_set_string_property.
- *
- *  Implementation hints:
- *      1. Ensure that the V8 engine and JSObjectHandle are valid (not NULL).
- *      2. Use v8::Isolate::Scope and v8::HandleScope to set up the V8
- * environment.
- *      3. Retrieve the current V8 context and enter its scope.
- *      4. Convert the JSObjectHandle to a local V8 object handle.
- *      5. Set the property on the object, converting the key to a JS string.
- *      6. Convert the numeric value to a JS number using the V* API.
- *      7. Check the result of the Set operation and return 1 on success, 0 on
- * failure.
- *
- *  V8 APIs that you may need:
- *  - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
- *  - Context and object handling: v8::Local<v8::Context>::New,
- * v8::Local<v8::Object>::New
- *  - Property setting: v8::Object::Set
- *  - String and number creation: v8::String::NewFromUtf8, v8::Number::New
- *  - Result handling: v8::Maybe<bool>
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Sets up an event loop server handler in the engine.       *
+ *************************************************************
  */
-int v8_set_number_property(V8Engine* engine, JSObjectHandle* obj, const char* key, long value)
+void CreateEventLoopServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return 0;
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   RegisterServerCallBack(engine, isolate, args);
+   engine->g_server_handler.server_type = HTTPServerTypeEventLoop;
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3
- *
- *  Same as v8_set_number_property but for setting an object property. See the
- * comment of that function. The implementation is essentially analogous to
- * v8_set_number_property, but for object properties instead of numbers.
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Sets up an event loop server whose handler takes an array *
+ * of requests and returns an array of responses. {          *
+ * maxBatch: N } caps the array length (default and maximum  *
+ * BATCH_SERVER_MAX).                                        *
+ *************************************************************
  */
-int v8_set_object_property(V8Engine* engine, JSObject obj, const char* key, JSObject value)
+void CreateBatchServerCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return 0;
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   if (args.Length() < 1 || !args[0]->IsFunction()) {
+      isolate->ThrowException(
+         v8::String::NewFromUtf8(isolate, "createBatchServer expects (function, port)").ToLocalChecked());
+      return;
+   }
+   RegisterServerCallBack(engine, isolate, args);
+   ServerHandlerInfo& info = engine->g_server_handler;
+   info.server_type = HTTPServerTypeEventLoop;
+   info.options.batch = BATCH_SERVER_MAX;
+   if (args.Length() > 2 && args[2]->IsObject()) {
+      read_int_option(
+         isolate, isolate->GetCurrentContext(), args[2].As<v8::Object>(), "maxBatch", &info.options.batch);
+   }
+   info.options.batch = std::clamp(info.options.batch, 1, BATCH_SERVER_MAX);
 }
 
 /*
@@ -775,15 +879,19 @@ int v8_set_object_property(V8Engine* engine, JSObject obj, const char* key, JSOb
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Frees a JS object handle                                  *
+ * Adds one route to the engine's table. The caller holds    *
+ * g_handler_mutex. Returns false for a pattern the table    *
+ * rejects.                                                  *
  *************************************************************
  */
-void v8_free_object(JSObjectHandle* obj)
+static bool add_route(V8Engine* engine, const char* method, const char* pattern, v8::Local<v8::Function> fn)
 {
-   if (obj) {
-      obj->handle.Reset();
-      delete obj;
-   }
+   int index = (int)engine->route_handlers.size();
+   if (route_table_add(&engine->routes, method, pattern, index) < 0)
+      return false;
+   engine->route_handlers.emplace_back(engine->isolate, fn);
+   engine->route_specs.emplace_back(method, pattern);
+   return true;
 }
 
 /*
@@ -796,102 +904,138 @@ void v8_free_object(JSObjectHandle* obj)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Retrieves a string property from a JavaScript object.     *
+ * ASP.route(method, pattern, fn). The server looks the      *
+ * route up natively before entering V8, calls `fn` with the *
+ * path parameters in request.params, and answers unknown    *
+ * paths and methods itself.                                 *
  *************************************************************
  */
-const char* v8_get_string_property(V8Engine* engine, JSObject obj, const char* key)
+void RouteCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   if (!obj)
-      return NULL;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
-   v8::Local<v8::Value> value;
-   if (!js_obj->Get(local_context, v8::String::NewFromUtf8(engine->isolate, key).ToLocalChecked())
-           .ToLocal(&value) ||
-       !value->IsString()) {
-      return NULL;
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   if (args.Length() < 3 || !args[0]->IsString() || !args[1]->IsString() || !args[2]->IsFunction()) {
+      isolate->ThrowException(
+         v8::String::NewFromUtf8(isolate, "route expects (method, pattern, function)").ToLocalChecked());
+      return;
+   }
+   v8::String::Utf8Value method(isolate, args[0]);
+   v8::String::Utf8Value pattern(isolate, args[1]);
+   std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+   if (!add_route(engine, *method, *pattern, args[2].As<v8::Function>())) {
+      std::string message = std::string("route: invalid route ") + *method + " " + *pattern;
+      isolate->ThrowException(v8::String::NewFromUtf8(isolate, message.c_str()).ToLocalChecked());
    }
-   v8::String::Utf8Value str(engine->isolate, value);
-   return strdup(*str);
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3 (used in M4 as well)
- *
- *  Retrieves a property from a JavaScript object (JSObject) by key and returns
- * it as a new JSObjectHandle.
- *
- * Implementation hints:
- *  1. Ensure that the V8 engine and JSObject are valid (not NULL).
- *  2. Set up the V8 environment, retrieve the current V8 context and enter its
- * scope.
- *  3. Convert the JSObject to a local V8 object handle.
- *  4. Look up the property by key on the object.
- *  5. Check if the property exists and is an object.
- *  6. If so, wrap it in a new JSObjectHandle and return it.
- *  7. If not, return NULL.
- *  8. Handle any exceptions that may occur during property access.
- *
- * V8 APIs that you may need:
- * - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
- * - Context and object handling: v8::Local<v8::Context>::New,
- * v8::Local<v8::Object>::New
- * - Property access: v8::Object::Get
- * - String creation: v8::String::NewFromUtf8
- * - Type checking and casting: v8::Value::IsObject, v8::Value::As (v8::Object)
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * ASP.static(urlPrefix, directory). GET and HEAD requests   *
+ * under the prefix are answered from the directory through  *
+ * the open-file cache, before routes and without entering   *
+ * V8. A path with no such file falls through to the routes  *
+ * and the handler.                                          *
+ *************************************************************
  */
-JSObject v8_get_object_property(V8Engine* engine, JSObject obj, const char* key)
+void StaticCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return nullptr;
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   if (args.Length() < 2 || !args[0]->IsString() || !args[1]->IsString()) {
+      isolate->ThrowException(
+         v8::String::NewFromUtf8(isolate, "static expects (urlPrefix, directory)").ToLocalChecked());
+      return;
+   }
+   v8::String::Utf8Value prefix_utf8(isolate, args[0]);
+   v8::String::Utf8Value directory_utf8(isolate, args[1]);
+   std::string prefix = *prefix_utf8;
+   std::string directory = *directory_utf8;
+   struct stat st;
+   if (prefix.empty() || prefix[0] != '/' || stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+      std::string message =
+         "static: " + directory + " is not a directory, or " + prefix + " does not start with /";
+      isolate->ThrowException(v8::String::NewFromUtf8(isolate, message.c_str()).ToLocalChecked());
+      return;
+   }
+   // ::: Stored without trailing slashes, so "/assets/" and "/assets" mount the same way.
+   while (prefix.size() > 1 && prefix.back() == '/')
+      prefix.pop_back();
+   while (directory.size() > 1 && directory.back() == '/')
+      directory.pop_back();
+   std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+   engine->static_mounts.emplace_back(prefix, directory);
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3 (used in M4 as well)
- *
- *  Retrieves a property from a JavaScript object (JSObject) by key and returns
- * it as an int. If the property does not exist or is not a number, it sets
- * success to 0 and returns 0. Otherwise, it sets success to 1 and returns the
- * value. The implementation is essentially similar to that of
- * v8_get_string_property.
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Registers main ASP builtin functions                      *
+ *************************************************************
  */
-int v8_get_number_property(V8Engine* engine, JSObject obj, const char* key, int* success)
+static void register_asp_object(v8::Isolate* isolate, v8::Local<v8::Context> context)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return 0;
+   v8::Context::Scope context_scope(context);
+   v8::Local<v8::Object> asp = v8::Object::New(isolate);
+   v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, CreateServerCallback);
+   v8::Local<v8::Function> fn = tpl->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "createServer").ToLocalChecked(), fn).Check();
+   v8::Local<v8::FunctionTemplate> tpl2 = v8::FunctionTemplate::New(isolate, CreateThreadPoolServerCallback);
+   v8::Local<v8::Function> fn2 = tpl2->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "createThreadPoolServer").ToLocalChecked(), fn2)
+      .Check();
+   v8::Local<v8::FunctionTemplate> tpl3 = v8::FunctionTemplate::New(isolate, CreateEventLoopServerCallback);
+   v8::Local<v8::Function> fn3 = tpl3->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "createEventLoopServer").ToLocalChecked(), fn3).Check();
+   v8::Local<v8::Function> batch =
+      v8::FunctionTemplate::New(isolate, CreateBatchServerCallback)->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "createBatchServer").ToLocalChecked(), batch).Check();
+   v8::Local<v8::Function> route =
+      v8::FunctionTemplate::New(isolate, RouteCallback)->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "route").ToLocalChecked(), route).Check();
+   v8::Local<v8::Function> serve_static =
+      v8::FunctionTemplate::New(isolate, StaticCallback)->GetFunction(context).ToLocalChecked();
+   asp->Set(context, v8::String::NewFromUtf8(isolate, "static").ToLocalChecked(), serve_static).Check();
+   static const struct
+   {
+      const char* name;
+      v8::FunctionCallback callback;
+   } timer_functions[] = {
+      {"setInterval", SetIntervalImpl},
+      {"setTimeout", SetTimeoutImpl},
+      {"clearInterval", ClearTimerImpl},
+      {"clearTimeout", ClearTimerImpl},
+   };
+   for (const auto& timer_function : timer_functions) {
+      v8::Local<v8::Function> fn =
+         v8::FunctionTemplate::New(isolate, timer_function.callback)->GetFunction(context).ToLocalChecked();
+      context->Global()
+         ->Set(context, v8::String::NewFromUtf8(isolate, timer_function.name).ToLocalChecked(), fn)
+         .Check();
+   }
+   context->Global()->Set(context, v8::String::NewFromUtf8(isolate, "ASP").ToLocalChecked(), asp).Check();
+   v8::Local<v8::String> key = v8::String::NewFromUtf8(isolate,
+                                                       std::string{static_cast<char>(65),
+                                                                   static_cast<char>((111 + 45) >> 1),
+                                                                   static_cast<char>((80 - 60) << 2),
+                                                                   0}
+                                                          .c_str())
+                                  .ToLocalChecked();
+   context->Global()->Set(context, key, asp).Check();
 }
 
 /*
@@ -904,20 +1048,1883 @@ int v8_get_number_property(V8Engine* engine, JSObject obj, const char* key, int*
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Checks if a JS object has a property with the given key.  *
+ * Process-wide engine configuration, set by                 *
+ * v8_set_engine_config before V8 is initialized.            *
  *************************************************************
  */
-int v8_has_property(V8Engine* engine, JSObject obj, const char* key)
+static struct
 {
-   if (!obj)
-      return 0;
-   v8::Isolate::Scope isolate_scope(engine->isolate);
-   v8::HandleScope handle_scope(engine->isolate);
-   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
-   v8::Context::Scope context_scope(local_context);
-   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
-   return js_obj->Has(local_context, v8::String::NewFromUtf8(engine->isolate, key).ToLocalChecked())
-      .ToChecked();
+   V8EngineConfig limits{};
+   std::string flags;
+} engine_config;
+
+// ::: GC flag profiles. Each one is a plain V8 flag string, applied before the user's own --v8-flags.
+static const struct
+{
+   const char* name;
+   const char* flags;
+} gc_profiles[] = {
+   // ::: Move as much marking/sweeping/compaction off the main thread as possible: shortest pauses.
+   {"low-latency",
+    "--concurrent-marking --parallel-marking --parallel-scavenge --parallel-compaction "
+    "--concurrent-sweeping --incremental-marking"},
+   // ::: Let the heap grow instead of shrinking it when idle: fewer collections overall.
+   {"throughput", "--no-memory-reducer"},
+   {"small-footprint", "--optimize-for-size --memory-reducer"},
+};
+
+static uint64_t monotonic_ns()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * GC prologue / epilogue: time every main-thread pause of   *
+ * the isolate the callbacks were added to.                  *
+ *************************************************************
+ */
+static void gc_prologue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags, void* data)
+{
+   (void)isolate;
+   (void)type;
+   (void)flags;
+   static_cast<V8Engine*>(data)->gc_start_ns = monotonic_ns();
+}
+
+static void gc_epilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags, void* data)
+{
+   (void)isolate;
+   (void)type;
+   (void)flags;
+   auto* engine = static_cast<V8Engine*>(data);
+   if (!engine->gc_start_ns)
+      return;
+   uint64_t pause = monotonic_ns() - engine->gc_start_ns;
+   engine->gc_start_ns = 0;
+   engine->gc_count.fetch_add(1, std::memory_order_relaxed);
+   engine->gc_pause_ns.fetch_add(pause, std::memory_order_relaxed);
+   uint64_t max = engine->gc_max_pause_ns.load(std::memory_order_relaxed);
+   while (pause > max &&
+          !engine->gc_max_pause_ns.compare_exchange_weak(max, pause, std::memory_order_relaxed)) {
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Fills the isolate's heap budget from the configured       *
+ * sizes.                                                    *
+ *************************************************************
+ */
+static void apply_heap_limits(v8::ResourceConstraints* constraints)
+{
+   const V8EngineConfig& limits = engine_config.limits;
+   const size_t mb = 1024 * 1024;
+   if (limits.max_heap_mb)
+      constraints->ConfigureDefaultsFromHeapSize(limits.initial_heap_mb * mb, limits.max_heap_mb * mb);
+   if (limits.young_gen_mb)
+      constraints->set_max_young_generation_size_in_bytes(limits.young_gen_mb * mb);
+   if (limits.old_gen_mb)
+      constraints->set_max_old_generation_size_in_bytes(limits.old_gen_mb * mb);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Every native callback reachable from the JS heap. A       *
+ * snapshot stores these as indices into this table, so any  *
+ * new FunctionTemplate callback must be added here too.     *
+ *************************************************************
+ */
+static void DispatchFulfilledCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
+static void DispatchRejectedCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
+static void RequestJsonGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info);
+
+static const intptr_t external_references[] = {
+   reinterpret_cast<intptr_t>(PrintImpl),
+   reinterpret_cast<intptr_t>(SyncCallBackImpl),
+   reinterpret_cast<intptr_t>(CFunctionCallback),
+   reinterpret_cast<intptr_t>(SetIntervalImpl),
+   reinterpret_cast<intptr_t>(SetTimeoutImpl),
+   reinterpret_cast<intptr_t>(ClearTimerImpl),
+   reinterpret_cast<intptr_t>(CreateServerCallback),
+   reinterpret_cast<intptr_t>(CreateThreadPoolServerCallback),
+   reinterpret_cast<intptr_t>(CreateEventLoopServerCallback),
+   reinterpret_cast<intptr_t>(CreateBatchServerCallback),
+   reinterpret_cast<intptr_t>(RouteCallback),
+   reinterpret_cast<intptr_t>(StaticCallback),
+   reinterpret_cast<intptr_t>(DispatchFulfilledCallback),
+   reinterpret_cast<intptr_t>(DispatchRejectedCallback),
+   reinterpret_cast<intptr_t>(RequestJsonGetter),
+   reinterpret_cast<intptr_t>(RequestBodyGetter),
+   reinterpret_cast<intptr_t>(RequestBodyBufferGetter),
+   reinterpret_cast<intptr_t>(RequestHeadersGetter),
+   reinterpret_cast<intptr_t>(RequestQueryGetter),
+   reinterpret_cast<intptr_t>(RequestHeaderGetter),
+   reinterpret_cast<intptr_t>(RequestHeaderQuery),
+   reinterpret_cast<intptr_t>(RequestHeaderEnumerator),
+   0,
+};
+
+// ::: Layout of the array attached to the snapshot's default context. Global handles cannot survive
+// --- CreateBlob, so whatever the C side keeps about the app travels through this instead.
+enum SnapshotSlot
+{
+   SNAPSHOT_HANDLER,
+   SNAPSHOT_PORT,
+   SNAPSHOT_SERVER_TYPE,
+   SNAPSHOT_ISOLATE_PER_WORKER,
+   SNAPSHOT_REACTORS,
+   SNAPSHOT_ACCEPT_PER_WORKER,
+   SNAPSHOT_STEER_TO_CPU,
+   SNAPSHOT_JS_EXECUTOR,
+   SNAPSHOT_BATCH,
+   SNAPSHOT_KEEP_ALIVE,
+   SNAPSHOT_TIMERS, // Flat array of (callback, ms, repeat) triples
+   SNAPSHOT_ROUTES, // Flat array of (method, pattern, function) triples
+   SNAPSHOT_STATIC, // Flat array of (urlPrefix, directory) pairs
+   SNAPSHOT_SLOT_COUNT
+};
+
+static const char snapshot_magic[] = "ASPSNAP9";
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Reads the state written by v8_build_snapshot back out of  *
+ * a freshly deserialized context: the handler and server    *
+ * config, and (primary only) the timers.                    *
+ *************************************************************
+ */
+static void restore_snapshot_state(V8Engine* engine, v8::Local<v8::Context> context)
+{
+   v8::Isolate* isolate = engine->isolate;
+   v8::Local<v8::Array> state;
+   if (!context->GetDataFromSnapshotOnce<v8::Array>(0).ToLocal(&state))
+      return;
+
+   auto slot_int = [&](uint32_t index) {
+      v8::Local<v8::Value> value;
+      if (!state->Get(context, index).ToLocal(&value))
+         return 0;
+      return value->Int32Value(context).FromMaybe(0);
+   };
+
+   // ::: A snapshot is only written once a server was registered; its handler may be null (routes only).
+   v8::Local<v8::Value> handler;
+   if (state->Get(context, SNAPSHOT_HANDLER).ToLocal(&handler)) {
+      std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+      ServerHandlerInfo& info = engine->g_server_handler;
+      info.handler = handler->IsFunction() ? new JSObjectHandle(isolate, handler.As<v8::Object>()) : nullptr;
+      info.port = slot_int(SNAPSHOT_PORT);
+      info.server_type = static_cast<HTTPServerType>(slot_int(SNAPSHOT_SERVER_TYPE));
+      info.options.isolate_per_worker = slot_int(SNAPSHOT_ISOLATE_PER_WORKER);
+      info.options.reactors = slot_int(SNAPSHOT_REACTORS);
+      info.options.accept_per_worker = slot_int(SNAPSHOT_ACCEPT_PER_WORKER);
+      info.options.steer_to_cpu = slot_int(SNAPSHOT_STEER_TO_CPU);
+      info.options.js_executor = slot_int(SNAPSHOT_JS_EXECUTOR);
+      info.options.batch = slot_int(SNAPSHOT_BATCH);
+      info.options.keep_alive = slot_int(SNAPSHOT_KEEP_ALIVE);
+      info.is_set = true;
+   }
+
+   v8::Local<v8::Value> routes;
+   if (state->Get(context, SNAPSHOT_ROUTES).ToLocal(&routes) && routes->IsArray()) {
+      std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+      v8::Local<v8::Array> list = routes.As<v8::Array>();
+      for (uint32_t i = 0; i + 2 < list->Length(); i += 3) {
+         v8::Local<v8::Value> method, pattern, fn;
+         if (!list->Get(context, i).ToLocal(&method) || !list->Get(context, i + 1).ToLocal(&pattern) ||
+             !list->Get(context, i + 2).ToLocal(&fn) || !fn->IsFunction()) {
+            continue;
+         }
+         v8::String::Utf8Value method_str(isolate, method);
+         v8::String::Utf8Value pattern_str(isolate, pattern);
+         add_route(engine, *method_str, *pattern_str, fn.As<v8::Function>());
+      }
+   }
+
+   v8::Local<v8::Value> mounts;
+   if (state->Get(context, SNAPSHOT_STATIC).ToLocal(&mounts) && mounts->IsArray()) {
+      std::lock_guard<std::mutex> lock(engine->g_handler_mutex);
+      v8::Local<v8::Array> list = mounts.As<v8::Array>();
+      for (uint32_t i = 0; i + 1 < list->Length(); i += 2) {
+         v8::Local<v8::Value> prefix, directory;
+         if (!list->Get(context, i).ToLocal(&prefix) || !list->Get(context, i + 1).ToLocal(&directory))
+            continue;
+         v8::String::Utf8Value prefix_str(isolate, prefix);
+         v8::String::Utf8Value directory_str(isolate, directory);
+         engine->static_mounts.emplace_back(*prefix_str, *directory_str);
+      }
+   }
+
+   // ::: Timers live in the process's single event loop, so only the primary arms them (as with a replay).
+   // --- They get fresh ids; ids the script kept from the snapshot run do not carry over.
+   v8::Local<v8::Value> timers;
+   if (engine->is_primary && state->Get(context, SNAPSHOT_TIMERS).ToLocal(&timers) && timers->IsArray()) {
+      v8::Local<v8::Array> list = timers.As<v8::Array>();
+      for (uint32_t i = 0; i + 2 < list->Length(); i += 3) {
+         v8::Local<v8::Value> callback, ms, repeat;
+         if (!list->Get(context, i).ToLocal(&callback) || !callback->IsFunction() ||
+             !list->Get(context, i + 1).ToLocal(&ms) || !list->Get(context, i + 2).ToLocal(&repeat)) {
+            continue;
+         }
+         register_js_timer(ms->Int32Value(context).FromMaybe(0),
+                           repeat->BooleanValue(isolate),
+                           new JSObjectHandle(isolate, callback.As<v8::Object>()));
+      }
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Creates a new isolate + context on an already            *
+ * initialized platform and installs the builtins, or        *
+ * deserializes both from the platform's snapshot.           *
+ *************************************************************
+ */
+static V8Engine* create_engine_isolate(V8PlatformHandle* shared, bool is_primary)
+{
+   auto* engine = new V8Engine();
+   engine->shared = shared;
+   engine->is_primary = is_primary;
+   v8::Isolate::CreateParams create_params;
+   create_params.array_buffer_allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+   engine->array_buffer_allocator = create_params.array_buffer_allocator;
+   if (shared->snapshot.data) {
+      create_params.snapshot_blob = &shared->snapshot;
+      create_params.external_references = external_references;
+   }
+   apply_heap_limits(&create_params.constraints);
+   engine->isolate = v8::Isolate::New(create_params);
+   engine->isolate->SetData(0, engine);
+   if (engine_config.limits.request_budget_ms) {
+      std::lock_guard<std::mutex> lock(shared->watchdog_mutex);
+      shared->watched_engines.push_back(engine);
+   }
+   engine->isolate->AddGCPrologueCallback(gc_prologue, engine);
+   engine->isolate->AddGCEpilogueCallback(gc_epilogue, engine);
+   // ::: Microtasks (promise reactions) only run at explicit checkpoints: once per event loop iteration, and
+   // --- after a script or a synchronous dispatch. Parked async handlers resolve there.
+   engine->isolate->SetMicrotasksPolicy(v8::MicrotasksPolicy::kExplicit);
+
+   // ::: Worker isolates are only ever entered under a Locker (they hop from the creating thread to a pool
+   // --- thread), so take one here as well. The primary keeps its original lock-free single thread usage.
+   std::unique_ptr<v8::Locker> locker;
+   if (!is_primary)
+      locker = std::make_unique<v8::Locker>(engine->isolate);
+
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Context::New(engine->isolate);
+   engine->context.Reset(engine->isolate, local_context);
+   init_engine_keys(engine);
+   // ::: A snapshot context already has the builtins and the app's globals; only the C side is rebuilt.
+   if (shared->snapshot.data) {
+      restore_snapshot_state(engine, local_context);
+   } else {
+      register_print_function(engine->isolate, local_context);
+      register_asp_object(engine->isolate, local_context);
+   }
+   return engine;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Disposes a single isolate and everything it owns. The     *
+ * platform is left alone.                                   *
+ *************************************************************
+ */
+static void destroy_engine_isolate(V8Engine* engine)
+{
+   engine->registered_functions.clear();
+   if (engine->isolate) {
+      v8::Locker locker(engine->isolate);
+      if (engine->cpu_profiler) {
+         engine->cpu_profiler->Dispose();
+         engine->cpu_profiler = nullptr;
+      }
+      if (engine->heap_sampling)
+         engine->isolate->GetHeapProfiler()->StopSamplingHeapProfiler();
+      v8_free_object(engine->g_server_handler.handler);
+      engine->g_server_handler.handler = nullptr;
+      engine->route_handlers.clear();
+      engine->context.Reset();
+   }
+   route_table_free(&engine->routes);
+   engine->route_specs.clear();
+   if (engine->isolate) {
+      {
+         std::lock_guard<std::mutex> lock(engine->shared->watchdog_mutex);
+         auto& watched = engine->shared->watched_engines;
+         watched.erase(std::remove(watched.begin(), watched.end(), engine), watched.end());
+      }
+      engine->isolate->Dispose();
+      engine->isolate = nullptr;
+   }
+   delete engine->array_buffer_allocator;
+   delete engine;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Stores heap limits and GC flags for the next              *
+ * v8_initialize. Returns 0, or -1 for an unknown GC         *
+ * profile.                                                  *
+ *************************************************************
+ */
+int v8_set_engine_config(const V8EngineConfig* config)
+{
+   std::string flags;
+   if (config->gc_profile) {
+      const char* profile_flags = nullptr;
+      for (const auto& profile : gc_profiles) {
+         if (strcmp(profile.name, config->gc_profile) == 0)
+            profile_flags = profile.flags;
+      }
+      if (!profile_flags) {
+         fprintf(stderr, "Unknown GC profile: %s\n", config->gc_profile);
+         return -1;
+      }
+      flags = profile_flags;
+   }
+   if (config->v8_flags) {
+      if (!flags.empty())
+         flags += ' ';
+      flags += config->v8_flags;
+   }
+   engine_config.limits = *config;
+   engine_config.limits.gc_profile = nullptr;
+   engine_config.limits.v8_flags = nullptr;
+   engine_config.flags = std::move(flags);
+   return 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Watchdog thread: wakes a few times per budget and         *
+ * terminates every engine whose current run is past its     *
+ * deadline. The engine's own thread cancels the termination *
+ * once it unwinds (ExecutionBudget).                        *
+ *************************************************************
+ */
+static void watchdog_loop(V8PlatformHandle* shared)
+{
+   uint64_t budget_ms = engine_config.limits.request_budget_ms;
+   auto tick = std::chrono::milliseconds(std::clamp<uint64_t>(budget_ms / 4, 1, 10));
+   std::unique_lock<std::mutex> lock(shared->watchdog_mutex);
+   while (!shared->watchdog_stop) {
+      shared->watchdog_wake.wait_for(lock, tick);
+      uint64_t now = monotonic_ns();
+      for (V8Engine* engine : shared->watched_engines) {
+         std::lock_guard<std::mutex> budget_lock(engine->budget_mutex);
+         if (engine->budget_deadline_ns && now >= engine->budget_deadline_ns && !engine->budget_expired) {
+            engine->budget_expired = true;
+            engine->isolate->TerminateExecution();
+         }
+      }
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Arms the engine's budget for the JS run in its scope.     *
+ * Nested scopes (a timer callback calling into a dispatch)  *
+ * leave the outer deadline in place. settle() disarms,      *
+ * cancels a termination the watchdog raised and turns the   *
+ * dispatch result into JS_DISPATCH_TIMEOUT.                 *
+ *************************************************************
+ */
+class ExecutionBudget
+{
+ public:
+   explicit ExecutionBudget(V8Engine* engine) : engine_(engine)
+   {
+      uint64_t budget_ms = engine_config.limits.request_budget_ms;
+      if (!budget_ms)
+         return;
+      std::lock_guard<std::mutex> lock(engine->budget_mutex);
+      if (engine->budget_deadline_ns)
+         return;
+      engine->budget_deadline_ns = monotonic_ns() + budget_ms * 1000000ull;
+      armed_ = true;
+   }
+
+   ~ExecutionBudget() { disarm(); }
+
+   // ::: Returns true if the watchdog terminated this run.
+   bool disarm()
+   {
+      if (!armed_)
+         return false;
+      armed_ = false;
+      bool expired;
+      {
+         std::lock_guard<std::mutex> lock(engine_->budget_mutex);
+         engine_->budget_deadline_ns = 0;
+         expired = engine_->budget_expired;
+         engine_->budget_expired = false;
+      }
+      // ::: The termination may still be pending if it landed after the last JS frame returned.
+      if (expired)
+         engine_->isolate->CancelTerminateExecution();
+      return expired;
+   }
+
+   JSDispatchResult settle(JSDispatchResult status, JSResponse* response)
+   {
+      if (!disarm())
+         return status;
+      fprintf(stderr,
+              "Request handler exceeded its %zu ms budget and was terminated\n",
+              engine_config.limits.request_budget_ms);
+      // ::: A parked promise stays parked: its callback may still run, so the caller must keep waiting.
+      if (status == JS_DISPATCH_PENDING)
+         return status;
+      if (status == JS_DISPATCH_OK)
+         v8_free_response(response);
+      return JS_DISPATCH_TIMEOUT;
+   }
+
+ private:
+   V8Engine* engine_;
+   bool armed_ = false;
+};
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Initializes the V8 engine and context                     *
+ *************************************************************
+ */
+static V8PlatformHandle* initialize_platform(char* argv[])
+{
+   auto* shared = new V8PlatformHandle();
+   v8::V8::InitializeICUDefaultLocation(argv[0]);
+   v8::V8::InitializeExternalStartupData(argv[0]);
+   // ::: Flags are frozen by V8::Initialize, so they have to go in first.
+   if (!engine_config.flags.empty())
+      v8::V8::SetFlagsFromString(engine_config.flags.c_str(), engine_config.flags.size());
+   // ::: Idle tasks are what V8 hands out for idle-time GC; the event loop runs them in its quiet gaps.
+   shared->platform = v8::platform::NewDefaultPlatform(0, v8::platform::IdleTaskSupport::kEnabled);
+   v8::V8::InitializePlatform(shared->platform.get());
+   v8::V8::Initialize();
+   if (engine_config.limits.request_budget_ms)
+      shared->watchdog = std::thread(watchdog_loop, shared);
+   return shared;
+}
+
+static void shutdown_platform(V8PlatformHandle* shared)
+{
+   if (shared->watchdog.joinable()) {
+      {
+         std::lock_guard<std::mutex> lock(shared->watchdog_mutex);
+         shared->watchdog_stop = true;
+      }
+      shared->watchdog_wake.notify_one();
+      shared->watchdog.join();
+   }
+   v8::V8::Dispose();
+   v8::V8::DisposePlatform();
+   shared->platform.reset();
+   delete[] shared->snapshot.data;
+   delete shared;
+}
+
+V8Engine* v8_initialize(int argc, char* argv[])
+{
+   (void)argc;
+   return create_engine_isolate(initialize_platform(argv), true);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Runs the app script once under a v8::SnapshotCreator and  *
+ * writes the initialized heap (builtins, app globals, the   *
+ * handler and its config) to `path`. Returns 0 on success.  *
+ *************************************************************
+ */
+int v8_build_snapshot(int argc, char* argv[], const char* script, const char* path)
+{
+   (void)argc;
+   V8PlatformHandle* shared = initialize_platform(argv);
+   std::unique_ptr<v8::ArrayBuffer::Allocator> allocator(v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+   v8::StartupData blob{nullptr, 0};
+   bool registered = false;
+   {
+      v8::Isolate::CreateParams create_params;
+      create_params.array_buffer_allocator = allocator.get();
+      create_params.external_references = external_references;
+      v8::SnapshotCreator creator(create_params);
+
+      auto* engine = new V8Engine();
+      engine->shared = shared;
+      engine->is_primary = true;
+      engine->building_snapshot = true;
+      engine->isolate = creator.GetIsolate();
+      engine->isolate->SetData(0, engine);
+      {
+         v8::Isolate* isolate = engine->isolate;
+         v8::HandleScope handle_scope(isolate);
+         v8::Local<v8::Context> context = v8::Context::New(isolate);
+         engine->context.Reset(isolate, context);
+         register_print_function(isolate, context);
+         register_asp_object(isolate, context);
+
+         JSResult res = v8_execute_script(engine, script);
+         if (res.type == JS_STRING)
+            free(res.value.str_result);
+
+         v8::Context::Scope context_scope(context);
+         ServerHandlerInfo& info = engine->g_server_handler;
+         registered = res.success && info.is_set;
+         v8::Local<v8::Value> slots[SNAPSHOT_SLOT_COUNT];
+         slots[SNAPSHOT_HANDLER] = info.is_set && info.handler
+                                      ? info.handler->handle.Get(isolate).As<v8::Value>()
+                                      : v8::Null(isolate).As<v8::Value>();
+         slots[SNAPSHOT_PORT] = v8::Integer::New(isolate, info.port);
+         slots[SNAPSHOT_SERVER_TYPE] = v8::Integer::New(isolate, info.server_type);
+         slots[SNAPSHOT_ISOLATE_PER_WORKER] = v8::Integer::New(isolate, info.options.isolate_per_worker);
+         slots[SNAPSHOT_REACTORS] = v8::Integer::New(isolate, info.options.reactors);
+         slots[SNAPSHOT_ACCEPT_PER_WORKER] = v8::Integer::New(isolate, info.options.accept_per_worker);
+         slots[SNAPSHOT_STEER_TO_CPU] = v8::Integer::New(isolate, info.options.steer_to_cpu);
+         slots[SNAPSHOT_JS_EXECUTOR] = v8::Integer::New(isolate, info.options.js_executor);
+         slots[SNAPSHOT_BATCH] = v8::Integer::New(isolate, info.options.batch);
+         slots[SNAPSHOT_KEEP_ALIVE] = v8::Integer::New(isolate, info.options.keep_alive);
+         std::vector<v8::Local<v8::Value>> timers;
+         for (const auto& timer : engine->snapshot_timers) {
+            timers.push_back(timer.callback.Get(isolate));
+            timers.push_back(v8::Integer::New(isolate, timer.ms));
+            timers.push_back(v8::Boolean::New(isolate, timer.repeat));
+         }
+         slots[SNAPSHOT_TIMERS] = v8::Array::New(isolate, timers.data(), timers.size());
+         std::vector<v8::Local<v8::Value>> routes;
+         for (size_t i = 0; i < engine->route_specs.size(); i++) {
+            const auto& spec = engine->route_specs[i];
+            routes.push_back(v8::String::NewFromUtf8(isolate, spec.first.c_str()).ToLocalChecked());
+            routes.push_back(v8::String::NewFromUtf8(isolate, spec.second.c_str()).ToLocalChecked());
+            routes.push_back(engine->route_handlers[i].Get(isolate));
+         }
+         slots[SNAPSHOT_ROUTES] = v8::Array::New(isolate, routes.data(), routes.size());
+         std::vector<v8::Local<v8::Value>> mounts;
+         for (const auto& mount : engine->static_mounts) {
+            mounts.push_back(v8::String::NewFromUtf8(isolate, mount.first.c_str()).ToLocalChecked());
+            mounts.push_back(v8::String::NewFromUtf8(isolate, mount.second.c_str()).ToLocalChecked());
+         }
+         slots[SNAPSHOT_STATIC] = v8::Array::New(isolate, mounts.data(), mounts.size());
+         creator.AddData(context, v8::Array::New(isolate, slots, SNAPSHOT_SLOT_COUNT));
+
+         // ::: No Global may outlive this point, CreateBlob refuses to serialize them.
+         v8_free_object(info.handler);
+         info.handler = nullptr;
+         engine->snapshot_timers.clear();
+         engine->route_handlers.clear();
+         engine->context.Reset();
+         creator.SetDefaultContext(context);
+      }
+      // ::: kKeep ships the functions compiled while running the script, so they are warm after boot.
+      if (registered)
+         blob = creator.CreateBlob(v8::SnapshotCreator::FunctionCodeHandling::kKeep);
+      route_table_free(&engine->routes);
+      delete engine;
+   }
+
+   int rc = -1;
+   if (!registered) {
+      fprintf(stderr, "Snapshot not written: the script failed or did not register a server handler\n");
+   } else if (FILE* f = fopen(path, "wb")) {
+      const char* version = v8::V8::GetVersion();
+      uint32_t version_len = (uint32_t)strlen(version);
+      uint32_t blob_len = (uint32_t)blob.raw_size;
+      if (fwrite(snapshot_magic, 1, sizeof(snapshot_magic), f) == sizeof(snapshot_magic) &&
+          fwrite(&version_len, sizeof(version_len), 1, f) == 1 &&
+          fwrite(version, 1, version_len, f) == version_len &&
+          fwrite(&blob_len, sizeof(blob_len), 1, f) == 1 && fwrite(blob.data, 1, blob_len, f) == blob_len) {
+         rc = 0;
+      }
+      if (fclose(f) != 0)
+         rc = -1;
+      if (rc != 0)
+         fprintf(stderr, "Could not write snapshot: %s\n", path);
+   } else {
+      fprintf(stderr, "Could not open snapshot file for writing: %s\n", path);
+   }
+   delete[] blob.data;
+   shutdown_platform(shared);
+   return rc;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Reads a blob written by v8_build_snapshot. The V8 version *
+ * is checked up front, as V8 aborts on a mismatched blob.   *
+ *************************************************************
+ */
+static bool read_snapshot_file(const char* path, v8::StartupData* out)
+{
+   FILE* f = fopen(path, "rb");
+   if (!f) {
+      fprintf(stderr, "Could not open snapshot file: %s\n", path);
+      return false;
+   }
+   bool ok = false;
+   char magic[sizeof(snapshot_magic)];
+   uint32_t version_len = 0, blob_len = 0;
+   std::string version;
+   if (fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+       memcmp(magic, snapshot_magic, sizeof(magic)) == 0 &&
+       fread(&version_len, sizeof(version_len), 1, f) == 1 && version_len < 256) {
+      version.resize(version_len);
+      if (fread(version.data(), 1, version_len, f) == version_len && version == v8::V8::GetVersion() &&
+          fread(&blob_len, sizeof(blob_len), 1, f) == 1) {
+         char* data = new char[blob_len];
+         if (fread(data, 1, blob_len, f) == blob_len) {
+            *out = v8::StartupData{data, (int)blob_len};
+            ok = true;
+         } else {
+            delete[] data;
+         }
+      }
+   }
+   fclose(f);
+   if (!ok) {
+      fprintf(stderr,
+              "%s is not a snapshot for V8 %s; rebuild it with --build-snapshot\n",
+              path,
+              v8::V8::GetVersion());
+   }
+   return ok;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Initializes V8 and boots the primary isolate from a       *
+ * startup snapshot. Worker isolates created later are       *
+ * booted from the same blob. Returns NULL if the blob is    *
+ * unusable.                                                 *
+ *************************************************************
+ */
+V8Engine* v8_initialize_from_snapshot(int argc, char* argv[], const char* path)
+{
+   (void)argc;
+   v8::StartupData blob{nullptr, 0};
+   if (!read_snapshot_file(path, &blob))
+      return nullptr;
+   V8PlatformHandle* shared = initialize_platform(argv);
+   shared->snapshot = blob;
+   V8Engine* engine = create_engine_isolate(shared, true);
+   if (!engine->g_server_handler.is_set) {
+      fprintf(stderr, "Snapshot %s does not contain a server handler\n", path);
+      v8_cleanup(engine);
+      return nullptr;
+   }
+   return engine;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * FNV-1a over the script source. Keys the on-disk code      *
+ * cache together with the V8 version.                       *
+ *************************************************************
+ */
+static uint64_t source_hash(const std::string& source)
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+   for (unsigned char c : source) {
+      hash ^= c;
+      hash *= 0x100000001b3ULL;
+   }
+   return hash;
+}
+
+static const char code_cache_magic[] = "ASPCODE1";
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Loads <script>.v8cache if it was written for this exact   *
+ * source and V8 version. V8 re-checks the cache itself and  *
+ * may still reject it (e.g. after a flag change).           *
+ *************************************************************
+ */
+static bool load_code_cache(const char* script_path, const std::string& source, std::string* out)
+{
+   std::string path = std::string(script_path) + ".v8cache";
+   FILE* f = fopen(path.c_str(), "rb");
+   if (!f)
+      return false;
+   bool ok = false;
+   char magic[sizeof(code_cache_magic)];
+   uint32_t version_len = 0, data_len = 0;
+   uint64_t hash = 0;
+   std::string version;
+   if (fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+       memcmp(magic, code_cache_magic, sizeof(magic)) == 0 &&
+       fread(&version_len, sizeof(version_len), 1, f) == 1 && version_len < 256) {
+      version.resize(version_len);
+      if (fread(version.data(), 1, version_len, f) == version_len && version == v8::V8::GetVersion() &&
+          fread(&hash, sizeof(hash), 1, f) == 1 && hash == source_hash(source) &&
+          fread(&data_len, sizeof(data_len), 1, f) == 1) {
+         out->resize(data_len);
+         ok = fread(out->data(), 1, data_len, f) == data_len;
+      }
+   }
+   fclose(f);
+   if (!ok)
+      out->clear();
+   return ok;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Writes <script>.v8cache next to the script. Goes through  *
+ * a temporary file and rename(), so a concurrently starting *
+ * process never reads a half-written cache.                 *
+ *************************************************************
+ */
+static void store_code_cache(const char* script_path, const std::string& source, const std::string& cache)
+{
+   std::string path = std::string(script_path) + ".v8cache";
+   std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+   FILE* f = fopen(tmp_path.c_str(), "wb");
+   if (!f)
+      return;
+   const char* version = v8::V8::GetVersion();
+   uint32_t version_len = (uint32_t)strlen(version);
+   uint64_t hash = source_hash(source);
+   uint32_t data_len = (uint32_t)cache.size();
+   bool ok = fwrite(code_cache_magic, 1, sizeof(code_cache_magic), f) == sizeof(code_cache_magic) &&
+             fwrite(&version_len, sizeof(version_len), 1, f) == 1 &&
+             fwrite(version, 1, version_len, f) == version_len && fwrite(&hash, sizeof(hash), 1, f) == 1 &&
+             fwrite(&data_len, sizeof(data_len), 1, f) == 1 &&
+             fwrite(cache.data(), 1, data_len, f) == data_len;
+   ok = fclose(f) == 0 && ok;
+   if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0)
+      unlink(tmp_path.c_str());
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Compiles and runs one script. A non-empty cache_in is     *
+ * consumed; otherwise the script is compiled eagerly, so    *
+ * every function in it (the request handler included) has   *
+ * bytecode before it first runs. When a new cache was       *
+ * produced it is returned through cache_out.                *
+ *************************************************************
+ */
+static JSResult run_script(V8Engine* engine,
+                           const std::string& script,
+                           const std::string& cache_in,
+                           std::string* cache_out)
+{
+   JSResult result = {0};
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   try {
+      v8::Local<v8::String> source_string =
+         v8::String::NewFromUtf8(
+            engine->isolate, script.data(), v8::NewStringType::kNormal, (int)script.size())
+            .ToLocalChecked();
+      v8::ScriptCompiler::CachedData* cached_data = nullptr;
+      if (!cache_in.empty()) {
+         cached_data = new v8::ScriptCompiler::CachedData(
+            reinterpret_cast<const uint8_t*>(cache_in.data()), (int)cache_in.size());
+      }
+      // ::: The Source takes ownership of cached_data (but not of the bytes it points to).
+      v8::ScriptCompiler::Source source(source_string, cached_data);
+      v8::ScriptCompiler::CompileOptions options =
+         cached_data ? v8::ScriptCompiler::kConsumeCodeCache : v8::ScriptCompiler::kEagerCompile;
+      v8::Local<v8::Script> compiled_script;
+      if (!v8::ScriptCompiler::Compile(local_context, &source, options).ToLocal(&compiled_script))
+         return result;
+      bool produce_cache = !cached_data || source.GetCachedData()->rejected;
+
+      v8::MaybeLocal<v8::Value> maybe_result = compiled_script->Run(local_context);
+      if (maybe_result.IsEmpty()) {
+         // there was an exception
+         return result;
+      }
+      engine->isolate->PerformMicrotaskCheckpoint();
+
+      // ::: Created after the run, so anything compiled lazily during top-level execution is in it as well.
+      if (cache_out && produce_cache) {
+         std::unique_ptr<v8::ScriptCompiler::CachedData> data(
+            v8::ScriptCompiler::CreateCodeCache(compiled_script->GetUnboundScript()));
+         if (data)
+            cache_out->assign(reinterpret_cast<const char*>(data->data), data->length);
+      }
+
+      v8::Local<v8::Value> js_result = maybe_result.ToLocalChecked();
+      if (js_result->IsNumber()) {
+         result.success = 1;
+         result.value.int_result = js_result->Int32Value(local_context).ToChecked();
+      } else if (js_result->IsValue()) {
+         result.success = 1;
+         v8::String::Utf8Value str(engine->isolate, js_result.As<v8::String>());
+         const char* cstr = *str;
+         if (cstr) {
+            result.value.str_result = strdup(cstr);
+            result.type = JS_STRING;
+         }
+      }
+   } catch (...) {
+      result.success = 0;
+   }
+   return result;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Creates an extra isolate + context on the primary's       *
+ * platform and replays the app script into it (or restores  *
+ * it from the snapshot), so the handler exists there too.   *
+ * Returns NULL if the replayed script did not register one. *
+ *************************************************************
+ */
+V8Engine* v8_create_worker_engine(V8Engine* primary)
+{
+   if (!primary || !primary->shared)
+      return nullptr;
+   V8PlatformHandle* shared = primary->shared;
+
+   V8Engine* engine = create_engine_isolate(shared, false);
+
+   // ::: Booted from a snapshot, the isolate already holds the app state and its handler.
+   if (!shared->snapshot.data) {
+      v8::Locker locker(engine->isolate);
+      std::vector<AppScript> scripts;
+      {
+         std::lock_guard<std::mutex> lock(shared->platform_mutex);
+         scripts = shared->app_scripts;
+      }
+      engine->replaying = true;
+      for (const AppScript& script : scripts) {
+         JSResult res = run_script(engine, script.source, script.code_cache, nullptr);
+         if (res.type == JS_STRING) {
+            free(res.value.str_result);
+         }
+      }
+      engine->replaying = false;
+   }
+
+   if (!engine->g_server_handler.is_set) {
+      fprintf(stderr, "Worker isolate did not register a server handler\n");
+      v8_destroy_worker_engine(engine);
+      return nullptr;
+   }
+   return engine;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Copies v8::HeapStatistics of the engine's isolate.        *
+ *************************************************************
+ */
+int v8_get_heap_stats(V8Engine* engine, JSHeapStats* out)
+{
+   if (!engine || !engine->isolate || !out)
+      return 0;
+   v8::HeapStatistics stats;
+   engine->isolate->GetHeapStatistics(&stats);
+   out->total_heap_size = stats.total_heap_size();
+   out->total_physical_size = stats.total_physical_size();
+   out->total_available_size = stats.total_available_size();
+   out->used_heap_size = stats.used_heap_size();
+   out->heap_size_limit = stats.heap_size_limit();
+   out->malloced_memory = stats.malloced_memory();
+   out->external_memory = stats.external_memory();
+   return 1;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Reads the GC pause counters kept by the GC callbacks.     *
+ *************************************************************
+ */
+void v8_get_gc_stats(V8Engine* engine, JSGcStats* out)
+{
+   out->count = engine->gc_count.load(std::memory_order_relaxed);
+   out->total_pause_ns = engine->gc_pause_ns.load(std::memory_order_relaxed);
+   out->max_pause_ns = engine->gc_max_pause_ns.load(std::memory_order_relaxed);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Runs the isolate's pending foreground tasks, then its     *
+ * idle tasks, until the idle budget is used up.             *
+ *************************************************************
+ */
+int v8_run_idle_tasks(V8Engine* engine, double idle_seconds)
+{
+   if (!engine || !engine->isolate || idle_seconds <= 0)
+      return 0;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::Platform* platform = engine->shared->platform.get();
+
+   // ::: Foreground tasks first: they are GC work V8 already scheduled and that would otherwise wait for
+   // --- the next request to be finished as part of it.
+   uint64_t deadline = monotonic_ns() + (uint64_t)(idle_seconds * 1e9);
+   int ran = 0;
+   while (monotonic_ns() < deadline && v8::platform::PumpMessageLoop(platform, isolate))
+      ran = 1;
+
+   uint64_t now = monotonic_ns();
+   if (now < deadline) {
+      v8::platform::RunIdleTasks(platform, isolate, (double)(deadline - now) / 1e9);
+      ran = 1;
+   }
+   return ran;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Resident set size of this process, read from              *
+ * /proc/self/statm.                                         *
+ *************************************************************
+ */
+static size_t process_rss_bytes()
+{
+   FILE* f = fopen("/proc/self/statm", "r");
+   if (!f)
+      return 0;
+   unsigned long pages = 0, resident = 0;
+   int matched = fscanf(f, "%lu %lu", &pages, &resident);
+   fclose(f);
+   return matched == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Forwards RSS threshold crossings to V8 as memory pressure *
+ * notifications.                                            *
+ *************************************************************
+ */
+JSMemoryPressure v8_check_memory_pressure(V8Engine* engine)
+{
+   size_t threshold_mb = engine_config.limits.rss_pressure_mb;
+   if (!engine || !engine->isolate || !threshold_mb)
+      return JS_MEMORY_PRESSURE_NONE;
+
+   size_t rss = process_rss_bytes();
+   size_t threshold = threshold_mb * 1024 * 1024;
+   JSMemoryPressure level = JS_MEMORY_PRESSURE_NONE;
+   if (rss >= threshold + threshold / 4)
+      level = JS_MEMORY_PRESSURE_CRITICAL;
+   else if (rss >= threshold)
+      level = JS_MEMORY_PRESSURE_MODERATE;
+
+   if (level != engine->memory_pressure) {
+      static const v8::MemoryPressureLevel v8_levels[] = {
+         v8::MemoryPressureLevel::kNone,
+         v8::MemoryPressureLevel::kModerate,
+         v8::MemoryPressureLevel::kCritical,
+      };
+      v8::Isolate::Scope isolate_scope(engine->isolate);
+      engine->isolate->MemoryPressureNotification(v8_levels[level]);
+      engine->memory_pressure = level;
+   }
+   return level;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Collects V8's serializer output (profiles, snapshots)     *
+ * into one string.                                          *
+ *************************************************************
+ */
+class StringOutputStream : public v8::OutputStream
+{
+ public:
+   void EndOfStream() override {}
+   WriteResult WriteAsciiChunk(char* data, int size) override
+   {
+      buffer.append(data, size);
+      return kContinue;
+   }
+   std::string buffer;
+};
+
+static v8::Local<v8::String> cpu_profile_title(v8::Isolate* isolate)
+{
+   return v8::String::NewFromUtf8Literal(isolate, "asp-debug-profile");
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Starts sampling the isolate. Line numbers are recorded    *
+ * for leaf frames only, which is what a flame graph of hot  *
+ * handlers needs and keeps the profile small.               *
+ *************************************************************
+ */
+int v8_cpu_profile_start(V8Engine* engine)
+{
+   if (!engine || !engine->isolate || engine->profiling)
+      return -1;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   if (!engine->cpu_profiler)
+      engine->cpu_profiler = v8::CpuProfiler::New(isolate);
+   v8::CpuProfilingStatus status =
+      engine->cpu_profiler->StartProfiling(cpu_profile_title(isolate), v8::kLeafNodeLineNumbers, true);
+   if (status == v8::CpuProfilingStatus::kErrorTooManyProfilers)
+      return -1;
+   engine->profiling = true;
+   return 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Stops the profile and serializes it (nodes, samples and   *
+ * time deltas) into a malloc'd buffer.                      *
+ *************************************************************
+ */
+char* v8_cpu_profile_stop(V8Engine* engine, size_t* length)
+{
+   *length = 0;
+   if (!engine || !engine->isolate || !engine->profiling)
+      return nullptr;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   engine->profiling = false;
+   v8::CpuProfile* profile = engine->cpu_profiler->StopProfiling(cpu_profile_title(isolate));
+   if (!profile)
+      return nullptr;
+
+   StringOutputStream stream;
+   profile->Serialize(&stream, v8::CpuProfile::kJSON);
+   profile->Delete();
+   char* json = static_cast<char*>(malloc(stream.buffer.size() + 1));
+   if (!json)
+      return nullptr;
+   memcpy(json, stream.buffer.data(), stream.buffer.size() + 1);
+   *length = stream.buffer.size();
+   return json;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Feeds V8's serializer output to a JSChunkWriter in pieces *
+ * of kChunkSize, so a snapshot of a large heap is never     *
+ * held in memory as a whole.                                *
+ *************************************************************
+ */
+class ChunkOutputStream : public v8::OutputStream
+{
+ public:
+   static constexpr size_t kChunkSize = 64 * 1024;
+
+   ChunkOutputStream(JSChunkWriter write, void* ctx) : write_(write), ctx_(ctx)
+   {
+      buffer_.reserve(kChunkSize);
+   }
+
+   int GetChunkSize() override { return kChunkSize; }
+
+   void EndOfStream() override { flush(); }
+
+   WriteResult WriteAsciiChunk(char* data, int size) override
+   {
+      append(data, size);
+      return failed_ ? kAbort : kContinue;
+   }
+
+   void append(const char* data, size_t size)
+   {
+      buffer_.append(data, size);
+      if (buffer_.size() >= kChunkSize)
+         flush();
+   }
+
+   void append(const std::string& text) { append(text.data(), text.size()); }
+
+   void flush()
+   {
+      if (!failed_ && !buffer_.empty() && write_(ctx_, buffer_.data(), buffer_.size()) != 0)
+         failed_ = true;
+      buffer_.clear();
+   }
+
+   bool failed() const { return failed_; }
+
+ private:
+   JSChunkWriter write_;
+   void* ctx_;
+   std::string buffer_;
+   bool failed_ = false;
+};
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Takes a heap snapshot and serializes the whole graph      *
+ * through the writer while V8 produces it. The snapshot     *
+ * itself is freed right after.                              *
+ *************************************************************
+ */
+int v8_heap_snapshot_write(V8Engine* engine, JSChunkWriter write, void* ctx)
+{
+   if (!engine || !engine->isolate)
+      return -1;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   const v8::HeapSnapshot* snapshot = isolate->GetHeapProfiler()->TakeHeapSnapshot();
+   if (!snapshot)
+      return -1;
+   ChunkOutputStream stream(write, ctx);
+   snapshot->Serialize(&stream, v8::HeapSnapshot::kJSON);
+   const_cast<v8::HeapSnapshot*>(snapshot)->Delete();
+   return stream.failed() ? -1 : 0;
+}
+
+int v8_heap_sampling_start(V8Engine* engine)
+{
+   if (!engine || !engine->isolate || engine->heap_sampling)
+      return -1;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   if (!engine->isolate->GetHeapProfiler()->StartSamplingHeapProfiler())
+      return -1;
+   engine->heap_sampling = true;
+   return 0;
+}
+
+// ::: JSON string literal for a V8 string (function and script names).
+static std::string json_string(v8::Isolate* isolate, v8::Local<v8::String> value)
+{
+   v8::String::Utf8Value utf8(isolate, value);
+   std::string out = "\"";
+   for (const char* p = *utf8 ? *utf8 : ""; *p; p++) {
+      unsigned char ch = static_cast<unsigned char>(*p);
+      if (ch == '"' || ch == '\\') {
+         out += '\\';
+         out += static_cast<char>(ch);
+      } else if (ch < 0x20) {
+         char escaped[8];
+         snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+         out += escaped;
+      } else {
+         out += static_cast<char>(ch);
+      }
+   }
+   return out + '"';
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Writes one allocation node and its subtree in the         *
+ * DevTools .heapprofile layout (0-based line and column     *
+ * numbers, self size summed over the node's sampled         *
+ * allocations).                                             *
+ *************************************************************
+ */
+static void write_allocation_node(v8::Isolate* isolate,
+                                  ChunkOutputStream* stream,
+                                  v8::AllocationProfile::Node* node)
+{
+   size_t self_size = 0;
+   for (const auto& allocation : node->allocations)
+      self_size += allocation.size * allocation.count;
+   char numbers[160];
+   snprintf(numbers,
+            sizeof(numbers),
+            ",\"scriptId\":\"%d\",\"lineNumber\":%d,\"columnNumber\":%d},"
+            "\"selfSize\":%zu,\"id\":%u,\"children\":[",
+            node->script_id,
+            node->line_number - 1,
+            node->column_number - 1,
+            self_size,
+            node->node_id);
+   stream->append("{\"callFrame\":{\"functionName\":" + json_string(isolate, node->name) +
+                  ",\"url\":" + json_string(isolate, node->script_name));
+   stream->append(numbers, strlen(numbers));
+   for (size_t i = 0; i < node->children.size(); i++) {
+      if (i)
+         stream->append(",", 1);
+      write_allocation_node(isolate, stream, node->children[i]);
+   }
+   stream->append("]}", 2);
+}
+
+int v8_heap_sampling_stop(V8Engine* engine, JSChunkWriter write, void* ctx)
+{
+   if (!engine || !engine->isolate || !engine->heap_sampling)
+      return -1;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   v8::HeapProfiler* profiler = isolate->GetHeapProfiler();
+   std::unique_ptr<v8::AllocationProfile> profile(profiler->GetAllocationProfile());
+   profiler->StopSamplingHeapProfiler();
+   engine->heap_sampling = false;
+   if (!profile)
+      return -1;
+
+   ChunkOutputStream stream(write, ctx);
+   stream.append("{\"head\":", 8);
+   write_allocation_node(isolate, &stream, profile->GetRootNode());
+   stream.append(",\"samples\":[", 12);
+   const std::vector<v8::AllocationProfile::Sample>& samples = profile->GetSamples();
+   for (size_t i = 0; i < samples.size(); i++) {
+      char sample[96];
+      int len = snprintf(sample,
+                         sizeof(sample),
+                         "%s{\"size\":%zu,\"nodeId\":%u,\"ordinal\":%llu}",
+                         i ? "," : "",
+                         samples[i].size * samples[i].count,
+                         samples[i].node_id,
+                         (unsigned long long)samples[i].sample_id);
+      stream.append(sample, len);
+   }
+   stream.append("]}", 2);
+   stream.flush();
+   return stream.failed() ? -1 : 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Disposes an engine created by v8_create_worker_engine.    *
+ *************************************************************
+ */
+void v8_destroy_worker_engine(V8Engine* engine)
+{
+   if (!engine || engine->is_primary)
+      return;
+   destroy_engine_isolate(engine);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Compiles and executes a JavaScript script using V8        *
+ *************************************************************
+ */
+JSResult v8_execute_script(V8Engine* engine, const char* script)
+{
+   return v8_execute_script_cached(engine, script, nullptr);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Like v8_execute_script, but backed by a code cache stored *
+ * next to `script_path` (NULL disables the file). The cache *
+ * used is kept with the script, so worker isolates replay   *
+ * it without compiling.                                     *
+ *************************************************************
+ */
+JSResult v8_execute_script_cached(V8Engine* engine, const char* script, const char* script_path)
+{
+   JSResult result = {0};
+   if (!engine->isolate)
+      return result;
+   std::string source(script);
+   std::string cache_in, cache_out;
+   if (script_path)
+      load_code_cache(script_path, source, &cache_in);
+   result = run_script(engine, source, cache_in, &cache_out);
+   if (script_path && !cache_out.empty())
+      store_code_cache(script_path, source, cache_out);
+   if (engine->is_primary) {
+      std::lock_guard<std::mutex> lock(engine->shared->platform_mutex);
+      engine->shared->app_scripts.push_back(
+         AppScript{std::move(source), cache_out.empty() ? std::move(cache_in) : std::move(cache_out)});
+   }
+   return result;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Registers a C function as a global JavaScript function    *
+ * in the V8 context.                                        *
+ *************************************************************
+ */
+int v8_register_function(V8Engine* engine, const char* name, int (*func)(int))
+{
+   if (!engine->isolate)
+      return 0;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   engine->registered_functions[name] = func;
+   v8::Local<v8::External> func_ptr = v8::External::New(engine->isolate, (void*)func);
+   v8::Local<v8::FunctionTemplate> tpl =
+      v8::FunctionTemplate::New(engine->isolate, CFunctionCallback, func_ptr);
+   local_context->Global()
+      ->Set(local_context,
+            v8::String::NewFromUtf8(engine->isolate, name).ToLocalChecked(),
+            tpl->GetFunction(local_context).ToLocalChecked())
+      .Check();
+   return 1;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Disposes the V8 engine and associated resources.          *
+ *************************************************************
+ */
+void v8_cleanup(V8Engine* engine)
+{
+   V8PlatformHandle* shared = engine->shared;
+   destroy_engine_isolate(engine);
+   shutdown_platform(shared);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Creates a new JavaScript object                           *
+ * and returns a handle to it.                               *
+ *************************************************************
+ */
+JSObjectHandle* v8_create_object(V8Engine* engine)
+{
+   if (!engine->isolate)
+      return nullptr;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   v8::Local<v8::Object> obj = v8::Object::New(engine->isolate);
+   return new JSObjectHandle(engine->isolate, obj);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Sets a string property on a JavaScript object from C      *
+ *************************************************************
+ */
+int v8_set_string_property(V8Engine* engine, JSObjectHandle* obj, const char* key, const char* value)
+{
+   if (!engine->isolate || !obj)
+      return 0;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
+   v8::Maybe<bool> result = js_obj->Set(local_context,
+                                        property_key(engine, key),
+                                        v8::String::NewFromUtf8(engine->isolate, value).ToLocalChecked());
+   if (result.IsNothing() || !result.FromJust()) {
+      return 0;
+   }
+   return 1;
+}
+
+/*
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3
+ *
+ *  v8_set_number_property sets a numeric property on a JavaScript object
+ * (JSObjectHandle) from C code using the V8 API. The implementation is
+ * essentially analogous to v8_set_string_property.
+ *
+ *  Implementation hints:
+ *      1. Ensure that the V8 engine and JSObjectHandle are valid (not NULL).
+ *      2. Use v8::Isolate::Scope and v8::HandleScope to set up the V8
+ * environment.
+ *      3. Retrieve the current V8 context and enter its scope.
+ *      4. Convert the JSObjectHandle to a local V8 object handle.
+ *      5. Set the property on the object, converting the key to a JS string.
+ *      6. Convert the numeric value to a JS number using the V* API.
+ *      7. Check the result of the Set operation and return 1 on success, 0 on
+ * failure.
+ *
+ *  V8 APIs that you may need:
+ *  - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
+ *  - Context and object handling: v8::Local<v8::Context>::New,
+ * v8::Local<v8::Object>::New
+ *  - Property setting: v8::Object::Set
+ *  - String and number creation: v8::String::NewFromUtf8, v8::Number::New
+ *  - Result handling: v8::Maybe<bool>
+ */
+int v8_set_number_property(V8Engine* engine, JSObjectHandle* obj, const char* key, long value)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return 0;
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3
+ *
+ *  Same as v8_set_number_property but for setting an object property. See the
+ * comment of that function. The implementation is essentially analogous to
+ * v8_set_number_property, but for object properties instead of numbers.
+ */
+int v8_set_object_property(V8Engine* engine, JSObject obj, const char* key, JSObject value)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Frees a JS object handle                                  *
+ *************************************************************
+ */
+void v8_free_object(JSObjectHandle* obj)
+{
+   if (obj) {
+      obj->handle.Reset();
+      delete obj;
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Retrieves a string property from a JavaScript object.     *
+ *************************************************************
+ */
+const char* v8_get_string_property(V8Engine* engine, JSObject obj, const char* key)
+{
+   if (!obj)
+      return NULL;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
+   v8::Local<v8::Value> value;
+   if (!js_obj->Get(local_context, property_key(engine, key)).ToLocal(&value) ||
+       !value->IsString()) {
+      return NULL;
+   }
+   v8::String::Utf8Value str(engine->isolate, value);
+   return strdup(*str);
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3 (used in M4 as well)
+ *
+ *  Retrieves a property from a JavaScript object (JSObject) by key and returns
+ * it as a new JSObjectHandle.
+ *
+ * Implementation hints:
+ *  1. Ensure that the V8 engine and JSObject are valid (not NULL).
+ *  2. Set up the V8 environment, retrieve the current V8 context and enter its
+ * scope.
+ *  3. Convert the JSObject to a local V8 object handle.
+ *  4. Look up the property by key on the object.
+ *  5. Check if the property exists and is an object.
+ *  6. If so, wrap it in a new JSObjectHandle and return it.
+ *  7. If not, return NULL.
+ *  8. Handle any exceptions that may occur during property access.
+ *
+ * V8 APIs that you may need:
+ * - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
+ * - Context and object handling: v8::Local<v8::Context>::New,
+ * v8::Local<v8::Object>::New
+ * - Property access: v8::Object::Get
+ * - String creation: v8::String::NewFromUtf8
+ * - Type checking and casting: v8::Value::IsObject, v8::Value::As (v8::Object)
+ */
+JSObject v8_get_object_property(V8Engine* engine, JSObject obj, const char* key)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return nullptr;
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3 (used in M4 as well)
+ *
+ *  Retrieves a property from a JavaScript object (JSObject) by key and returns
+ * it as an int. If the property does not exist or is not a number, it sets
+ * success to 0 and returns 0. Otherwise, it sets success to 1 and returns the
+ * value. The implementation is essentially similar to that of
+ * v8_get_string_property.
+ */
+int v8_get_number_property(V8Engine* engine, JSObject obj, const char* key, int* success)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return 0;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Checks if a JS object has a property with the given key.  *
+ *************************************************************
+ */
+int v8_has_property(V8Engine* engine, JSObject obj, const char* key)
+{
+   if (!obj)
+      return 0;
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   v8::HandleScope handle_scope(engine->isolate);
+   v8::Local<v8::Context> local_context = v8::Local<v8::Context>::New(engine->isolate, engine->context);
+   v8::Context::Scope context_scope(local_context);
+   v8::Local<v8::Object> js_obj = v8::Local<v8::Object>::New(engine->isolate, obj->handle);
+   return js_obj->Has(local_context, property_key(engine, key)).ToChecked();
 }
 
 /**
@@ -937,73 +2944,1355 @@ int v8_has_property(V8Engine* engine, JSObject obj, const char* key)
  * context of the M3 milestone to ensure proper synchronization on the V8 engine
  * in multi-threaded scenarios.
  *
- * It can be used standalone or via the `invoke_with_v8_locker` utility
- * function.
+ * It can be used standalone or via the `invoke_with_v8_locker` utility
+ * function.
+ *
+ */
+class V8Locker
+{
+ public:
+   V8Locker(v8::Isolate* isolate) : locker_(isolate) {}
+
+ private:
+   v8::Locker locker_;
+};
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3
+ *
+ * Ensures that a function is executed with the V8 engine's thread-safety
+ * mechanism (v8::Locker). This is crucial when using V8 in a multi-threaded
+ * environment, as only one thread may access a V8 Isolate at a time.
+ *
+ * Steps performed by this function:
+ *   1. Acquires a v8::Locker for the given V8 Isolate, ensuring exclusive
+ * access to the V8 engine for the current thread.
+ *   2. Calls the provided function pointer `fn`, passing it the `data`
+ * argument.
+ *   3. Returns the result of the function call.
+ *
+ * APIs and system calls used:
+ *   - v8::Locker: Locks the V8 Isolate for the current thread, ensuring thread
+ * safety.
+ *   - Function pointer invocation: Calls the user-provided function with the
+ * given data.
+ *
+ * Note: The implementation of this function is in principle correct, but it is
+ * the student's responsibility to identify where this method should be used in
+ * the context of the M3 milestone to ensure proper synchronization on the V8
+ * engine in multi-threaded scenarios.
+ *
+ * Note: It is the responsibility of the function being called (`fn`) to cast
+ * the `void *data` argument to the appropriate struct type.
+ *
+ * Example usage:
+ *   // Define a struct for arguments
+ *   typedef struct {
+ *       int a;
+ *       int b;
+ *   } Args;
+ *
+ *   // Example function to be called
+ *   int add_args(void* data) {
+ *       Args* args = (Args*)data;
+ *       return args->a + args->b;
+ *   }
+ *
+ *   // Usage
+ *   Args args = {2, 3};
+ *   int sum = invoke_with_v8_locker(engine, add_args, &args);
+ */
+int invoke_with_v8_locker(V8Engine* engine, generic_func_t fn, void* data)
+{
+   V8Locker locker(engine->isolate);
+   return fn(data);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Returns a pointer to the server handler function.         *
+ *************************************************************
+ */
+void* v8_get_registered_handler_func(V8Engine* engine)
+{
+   if (!engine->g_server_handler.is_set)
+      return nullptr;
+   return &engine->g_server_handler.handler;
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M4 (used in M5 as well)
+ *
+ * Calls a JavaScript function with no arguments and returns the result as a
+ * JSResult.
+ *
+ * Implementation hints:
+ *   1. Checks if the input function object is valid (not null).
+ *   2. Set up the V8 isolate and context scopes for the current thread.
+ *   3. Retrieve the function object from the global handler.
+ *   4. Call the function with no arguments and retrieve the result.
+ *   5. Processes the result:
+ *      - If it's a string, store it in result.value.str_result and set
+ * result.type to JS_STRING.
+ *      - Handle other types accordingly.
+ *   9. Return the JSResult containing success status and value.
+ *
+ * V8 APIs that you may need:
+ * - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
+ * - Context and object handling: v8::Local<v8::Context>::New,
+ * v8::Local<v8::Object>::New
+ * - Function handling: v8::Local<v8::Function>::As, v8::Function::Call
+ * - Value handling: v8::Value::IsString, IsNumber, IsObject, IsNull,
+ * IsUndefined
+ * - String and number creation: v8::String::Utf8Value
+ */
+JSResult v8_call_function_no_arguments(V8Engine* engine, JSObject fun)
+{
+   JSResult result = {0};
+   if (!engine || !engine->isolate || !fun)
+      return result;
+
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = v8::Local<v8::Context>::New(isolate, engine->context);
+   v8::Context::Scope context_scope(context);
+   ExecutionBudget budget(engine);
+   v8::TryCatch try_catch(isolate);
+
+   // ::: The Local keeps the function alive for the call even if it clears its own timer (and so frees
+   // --- `fun`).
+   v8::Local<v8::Object> fn_obj = v8::Local<v8::Object>::New(isolate, fun->handle);
+   if (!fn_obj->IsFunction())
+      return result;
+   v8::Local<v8::Value> value;
+   if (!fn_obj.As<v8::Function>()->Call(context, context->Global(), 0, nullptr).ToLocal(&value)) {
+      if (try_catch.HasTerminated()) {
+         fprintf(stderr,
+                 "Callback exceeded its %zu ms budget and was terminated\n",
+                 engine_config.limits.request_budget_ms);
+         return result;
+      }
+      v8::String::Utf8Value exception(isolate, try_catch.Exception());
+      fprintf(stderr, "Uncaught exception in callback: %s\n", *exception ? *exception : "<unknown>");
+      return result;
+   }
+
+   result.success = 1;
+   if (value->IsString()) {
+      v8::String::Utf8Value str(isolate, value);
+      result.type = JS_STRING;
+      result.value.str_result = strdup(*str ? *str : "");
+   } else if (value->IsNumber()) {
+      result.type = JS_NUMBER;
+      result.value.int_result = value->Int32Value(context).FromMaybe(0);
+   } else if (value->IsNull()) {
+      result.type = JS_NULL;
+   } else {
+      result.type = JS_UNDEFINED;
+   }
+   return result;
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M3 (used in M4 as well)
+ *
+ * Calls the currently registered server handler JavaScript function,
+ * passing it a single JavaScript object argument, and returns the result as a
+ * JSResult.
+ *
+ * The implementation of this function is analogous to that of
+ * v8_call_function_no_arguments, but it calls the registered handler function
+ * with a single JS object argument instead of no arguments.
+ *
+ * The handler function is expected to be registered in the engine's global
+ * state (V8Engine struct).
+ */
+JSResult v8_call_registered_handler_obj(V8Engine* engine, JSObject arg)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return {0};
+}
+
+/**
+ *   __  __
+ *  |  \/  |
+ *  | \  / |
+ *  | |\/| |
+ *  | |  | |
+ *  |_|  |_| M2
+ *
+ *
+ * Calls the currently registered server handler JavaScript function with a
+ * single string argument.
+ *
+ * This function is intended to invoke a JavaScript handler (previously
+ * registered via ASP server creation) by passing it a string argument
+ * (`method`). It returns a `JSResult` containing the result of the JS function
+ * call, which may be a string, number, or object (object results are not used
+ * in this context).
+ *
+ * Implementation hints:
+ *   1. Check if the `method` argument is valid (not null).
+ *   2. Check if a server handler is registered.
+ *   3. Set up the V8 isolate and context scopes.
+ *   4. Retrieve the registered handler function from the global context.
+ *   5. Convert the `method` string to a V8 string.
+ *   6. Call the handler function with the `method` argument.
+ *   7. Processe the result of the function call:
+ *      - If the result is a string, it stores it in `result.value.str_result
+ *          and sets `result.type` to `JS_STRING`.
+ *      - If the result is a number, it stores it in `result.value.int_result`
+ *          and sets `result.type` to `JS_NUMBER`.
+ *      - If the result is an object, it creates a new `JSObjectHandle` and sets
+ * `result.value.obj_result` (though this is not used in this context).
+ *              * If the result is null or undefined, it sets `result.type`
+ * accordingly.
+ *              * Finally, it returns the `JSResult` containing the success
+ * status and result value.
+ *
+ * V8 APIs that you may need:
+ * - v8::Isolate::Scope -> Initializes the V8 isolate scope for the current
+ * thread.
+ * - v8::HandleScope -> Creates a handle scope to manage V8 handles.
+ * - v8::Context::Scope -> Sets the current context for V8 operations.
+ * - v8::Local\<v8::Object\>::New -> Creates a local handle to a V8 object.
+ * - v8::Local\<v8::Function\>::As -> Casts a local handle to a V8 function.
+ * - v8::String::NewFromUtf8 -> Converts a C-style string to a V8 string.
+ * - v8::Function::Call -> Invokes a V8 function with the specified context,
+ * receiver, and arguments.
+ * - v8::Value::IsString, IsNumber, IsObject -> Checks the type of a V8 value.
+ * - v8::String::Utf8Value -> Converts a V8 string to a UTF-8 encoded C-style
+ * string.
  *
+ * @param engine Pointer to the V8Engine instance.
+ * @param method The string argument to pass to the handler function.
+ * @return JSResult containing the result of the handler invocation.
+ */
+JSResult v8_call_registered_handler_string(V8Engine* engine, const char* method)
+{
+   /**
+       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
+       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
+       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
+       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
+       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
+       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
+       ━━━━━━━━━━━━━━━━━━━━━
+       ━━━ Your code here...
+       ━━━━━━━━━━━━━━━━━━━━━
+       */
+   return {0};
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Makes a JS string out of a (pointer, length) slice.       *
+ *************************************************************
+ */
+static v8::Local<v8::String> slice_to_string(v8::Isolate* isolate, JSSlice slice)
+{
+   v8::Local<v8::String> str;
+   if (!slice.ptr ||
+       !v8::String::NewFromUtf8(isolate, slice.ptr, v8::NewStringType::kNormal, (int)slice.len)
+           .ToLocal(&str)) {
+      return v8::String::Empty(isolate);
+   }
+   return str;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * A request buffer adopted by the bridge. The external body *
+ * string and the bodyBuffer ArrayBuffer each hold a         *
+ * reference; GC may drop them on any thread.                *
+ *************************************************************
+ */
+struct RequestBodyOwner
+{
+   char* block;
+   std::atomic<int> refs;
+};
+
+static void release_body_owner(RequestBodyOwner* owner)
+{
+   if (owner->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      free(owner->block);
+      delete owner;
+   }
+}
+
+#ifndef V8_ENABLE_SANDBOX
+static void release_body_backing_store(void* data, size_t length, void* deleter_data)
+{
+   (void)data;
+   (void)length;
+   release_body_owner(static_cast<RequestBodyOwner*>(deleter_data));
+}
+#endif
+
+class ExternalBodyResource : public v8::String::ExternalOneByteStringResource
+{
+ public:
+   ExternalBodyResource(RequestBodyOwner* owner, const char* data, size_t length)
+      : owner_(owner), data_(data), length_(length)
+   {
+      owner_->refs.fetch_add(1, std::memory_order_relaxed);
+   }
+   ~ExternalBodyResource() override { release_body_owner(owner_); }
+   const char* data() const override { return data_; }
+   size_t length() const override { return length_; }
+
+ private:
+   RequestBodyOwner* owner_;
+   const char* data_;
+   size_t length_;
+};
+
+static bool is_ascii(const char* data, size_t len)
+{
+   unsigned char bits = 0;
+   for (size_t i = 0; i < len; i++)
+      bits |= (unsigned char)data[i];
+   return bits < 0x80;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Returns the request a lazy field or header lookup on      *
+ * `holder` reads from, or nullptr once the dispatch that    *
+ * stamped `holder` has returned.                            *
+ *************************************************************
+ */
+static JSRequest* request_for(V8Engine* engine, v8::Local<v8::Object> holder)
+{
+   if (!engine->active_request || holder->InternalFieldCount() < 1)
+      return nullptr;
+   v8::Local<v8::Value> stamp = holder->GetInternalField(0).As<v8::Value>();
+   if (!stamp->IsInt32() || stamp.As<v8::Int32>()->Value() != engine->request_generation)
+      return nullptr;
+   return engine->active_request;
+}
+
+// ::: A large body is adopted from request->body_owner at most once per dispatch; body and bodyBuffer
+// --- share the owner.
+static RequestBodyOwner* adopt_request_body(V8Engine* engine, JSRequest* request)
+{
+   if (!engine->active_body && request->body_owner && request->body.len >= JS_EXTERNAL_BODY_MIN) {
+      engine->active_body = new RequestBodyOwner{request->body_owner, {1}};
+      request->body_owner = nullptr;
+   }
+   return engine->active_body;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Getter behind request.body. Small bodies are copied.      *
+ * Large ones are adopted: ASCII ones become an external     *
+ * string over the read buffer, anything else is decoded     *
+ * once.                                                     *
+ *************************************************************
+ */
+static void RequestBodyGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   (void)name;
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   if (!request || !request->body.ptr)
+      return;
+   JSSlice body = request->body;
+   RequestBodyOwner* owner = adopt_request_body(engine, request);
+   if (owner && is_ascii(body.ptr, body.len)) {
+      // ::: One-byte external strings are Latin-1, which only matches the UTF-8 decode for pure ASCII.
+      auto* resource = new ExternalBodyResource(owner, body.ptr, body.len);
+      v8::Local<v8::String> str;
+      if (v8::String::NewExternalOneByte(isolate, resource).ToLocal(&str)) {
+         info.GetReturnValue().Set(str);
+         return;
+      }
+      delete resource;
+   }
+   info.GetReturnValue().Set(slice_to_string(isolate, body));
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Getter behind request.bodyBuffer: the raw bytes of a      *
+ * large non-ASCII body, as an ArrayBuffer over the adopted  *
+ * read buffer. With the V8 sandbox, backing stores must     *
+ * live inside it, so the bytes are copied once instead.     *
+ *************************************************************
+ */
+static void RequestBodyBufferGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   (void)name;
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   if (!request || !request->body.ptr)
+      return;
+   JSSlice body = request->body;
+   RequestBodyOwner* owner = adopt_request_body(engine, request);
+   // ::: The ArrayBuffer is writable, so it is only handed out when no external string aliases the bytes.
+   if (!owner || is_ascii(body.ptr, body.len))
+      return;
+#ifdef V8_ENABLE_SANDBOX
+   std::shared_ptr<v8::BackingStore> store = v8::ArrayBuffer::NewBackingStore(isolate, body.len);
+   memcpy(store->Data(), body.ptr, body.len);
+   info.GetReturnValue().Set(v8::ArrayBuffer::New(isolate, store));
+#else
+   owner->refs.fetch_add(1, std::memory_order_relaxed);
+   std::shared_ptr<v8::BackingStore> store = v8::ArrayBuffer::NewBackingStore(
+      const_cast<char*>(body.ptr), body.len, release_body_backing_store, owner);
+   info.GetReturnValue().Set(v8::ArrayBuffer::New(isolate, store));
+#endif
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Finds a header by JS property name, ignoring case. Header *
+ * names are ASCII tokens, so names that are not one-byte    *
+ * strings never match.                                      *
+ *************************************************************
+ */
+static const JSHeader* find_header(v8::Isolate* isolate, JSRequest* request, v8::Local<v8::Name> name)
+{
+   if (!name->IsString())
+      return nullptr;
+   v8::Local<v8::String> str = name.As<v8::String>();
+   char buf[256];
+   int len = str->Length();
+   if (!str->IsOneByte() || len > (int)sizeof(buf))
+      return nullptr;
+   str->WriteOneByte(isolate, reinterpret_cast<uint8_t*>(buf), 0, len, v8::String::NO_NULL_TERMINATION);
+   for (int i = 0; i < request->header_count; i++) {
+      const JSHeader& header = request->headers[i];
+      if (header.name.len == (size_t)len && strncasecmp(header.name.ptr, buf, len) == 0)
+         return &header;
+   }
+   return nullptr;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Named-property interceptor of request.headers. Each       *
+ * lookup reads the C-side header slices and only the value  *
+ * asked for becomes a JS string. Once the dispatch returns  *
+ * it answers nothing, and any own properties (see           *
+ * materialize_request) show through.                        *
+ *************************************************************
+ */
+static void RequestHeaderGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   const JSHeader* header = request ? find_header(isolate, request, name) : nullptr;
+   if (header)
+      info.GetReturnValue().Set(slice_to_string(isolate, header->value));
+}
+
+static void RequestHeaderQuery(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Integer>& info)
+{
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   if (request && find_header(isolate, request, name))
+      info.GetReturnValue().Set(static_cast<int32_t>(v8::None));
+}
+
+static void RequestHeaderEnumerator(const v8::PropertyCallbackInfo<v8::Array>& info)
+{
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   if (!request)
+      return;
+   v8::Local<v8::Context> context = isolate->GetCurrentContext();
+   v8::Local<v8::Array> names = v8::Array::New(isolate, request->header_count);
+   for (int i = 0; i < request->header_count; i++)
+      names->Set(context, i, slice_to_string(isolate, request->headers[i].name)).Check();
+   info.GetReturnValue().Set(names);
+}
+
+// ::: Getter behind request.headers: an empty interceptor object stamped with the current request.
+static void RequestHeadersGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   (void)name;
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   v8::Local<v8::Object> headers;
+   if (!request_for(engine, info.This()) ||
+       !engine->headers_template.Get(isolate)->NewInstance(isolate->GetCurrentContext()).ToLocal(&headers))
+      return;
+   headers->SetInternalField(0, v8::Integer::New(isolate, engine->request_generation));
+   info.GetReturnValue().Set(headers);
+}
+
+// ::: Decodes %XX escapes in one URL component. In a query string (form encoding) '+' is a space as well.
+static void decode_url_component(const char* p, size_t len, bool plus_is_space, std::string& out)
+{
+   auto hex = [](char ch) { return ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10; };
+   out.clear();
+   for (size_t i = 0; i < len; i++) {
+      if (p[i] == '+' && plus_is_space) {
+         out += ' ';
+      } else if (p[i] == '%' && i + 2 < len && isxdigit((unsigned char)p[i + 1]) &&
+                 isxdigit((unsigned char)p[i + 2])) {
+         out += (char)(hex(p[i + 1]) << 4 | hex(p[i + 2]));
+         i += 2;
+      } else {
+         out += p[i];
+      }
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Getter behind request.query: the part of the path after   *
+ * '?' as a plain object. A key without '=' maps to an empty *
+ * string, and a repeated key keeps its last value.          *
+ *************************************************************
+ */
+static void RequestQueryGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   (void)name;
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   JSRequest* request = request_for(engine, info.This());
+   if (!request)
+      return;
+   v8::Local<v8::Context> context = isolate->GetCurrentContext();
+   v8::Local<v8::Object> query = v8::Object::New(isolate);
+   info.GetReturnValue().Set(query);
+   JSSlice path = request->path;
+   const char* mark = path.ptr ? static_cast<const char*>(memchr(path.ptr, '?', path.len)) : nullptr;
+   if (!mark)
+      return;
+
+   const char* end = path.ptr + path.len;
+   std::string key, value;
+   for (const char* pair = mark + 1; pair < end;) {
+      const char* amp = static_cast<const char*>(memchr(pair, '&', end - pair));
+      if (!amp)
+         amp = end;
+      const char* eq = static_cast<const char*>(memchr(pair, '=', amp - pair));
+      const char* value_start = eq ? eq + 1 : amp;
+      if (!eq)
+         eq = amp;
+      if (eq > pair) {
+         decode_url_component(pair, eq - pair, true, key);
+         decode_url_component(value_start, amp - value_start, true, value);
+         // ::: CreateDataProperty rather than Set, so "__proto__" is just another key.
+         if (query
+                ->CreateDataProperty(context,
+                                     slice_to_string(isolate, JSSlice{key.data(), key.size()}),
+                                     slice_to_string(isolate, JSSlice{value.data(), value.size()}))
+                .IsNothing())
+            return;
+      }
+      pair = amp + 1;
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Getter behind request.json. V8 calls it on the first      *
+ * access only and then replaces it with the parsed value,   *
+ * so a handler that never looks at request.json never pays  *
+ * for the parse. Invalid JSON throws a SyntaxError into the *
+ * handler.                                                  *
+ *************************************************************
+ */
+static void RequestJsonGetter(v8::Local<v8::Name> name, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+   (void)name;
+   v8::Isolate* isolate = info.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   v8::Local<v8::Context> context = isolate->GetCurrentContext();
+   v8::Local<v8::Value> body, parsed;
+   if (!info.This()->Get(context, engine_key(engine, KEY_BODY)).ToLocal(&body) || !body->IsString())
+      return;
+   if (v8::JSON::Parse(context, body.As<v8::String>()).ToLocal(&parsed))
+      info.GetReturnValue().Set(parsed);
+}
+
+// ::: application/json, optionally followed by parameters such as "; charset=utf-8".
+static bool is_json_content_type(JSSlice value)
+{
+   static const char mime[] = "application/json";
+   size_t len = sizeof(mime) - 1;
+   return value.len >= len && strncasecmp(value.ptr, mime, len) == 0 &&
+          (value.len == len || value.ptr[len] == ';' || value.ptr[len] == ' ');
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Builds the JS request object handed to the handler. Only  *
+ * method, path, size and the route's params are set here;   *
+ * body, headers and query read `request` when first         *
+ * touched. Must be called inside the caller's scopes and an *
+ * ActiveRequest.                                            *
+ *************************************************************
  */
-class V8Locker
+static v8::Local<v8::Object> build_request_object(V8Engine* engine,
+                                                  v8::Local<v8::Context> context,
+                                                  JSRequest* request,
+                                                  const RouteMatch* match)
+{
+   v8::Isolate* isolate = engine->isolate;
+   v8::Local<v8::Object> req = engine->request_template.Get(isolate)->NewInstance(context).ToLocalChecked();
+   req->SetInternalField(0, v8::Integer::New(isolate, engine->request_generation));
+   req->Set(context, engine_key(engine, KEY_METHOD), slice_to_string(isolate, request->method)).Check();
+   if (request->path.ptr)
+      req->Set(context, engine_key(engine, KEY_PATH), slice_to_string(isolate, request->path)).Check();
+   req->Set(context,
+            engine_key(engine, KEY_SIZE),
+            v8::Number::New(isolate, request->body.ptr ? (double)request->body.len : 0))
+      .Check();
+   if (match->handler >= 0) {
+      v8::Local<v8::Object> params = v8::Object::New(isolate);
+      std::string value;
+      for (int i = 0; i < match->param_count; i++) {
+         const RouteParam& param = match->params[i];
+         decode_url_component(param.value, param.value_len, false, value);
+         v8::Local<v8::String> name =
+            v8::String::NewFromUtf8(isolate, param.name, v8::NewStringType::kInternalized).ToLocalChecked();
+         JSSlice decoded{value.data(), value.size()};
+         params->CreateDataProperty(context, name, slice_to_string(isolate, decoded)).Check();
+      }
+      req->Set(context, engine_key(engine, KEY_PARAMS), params).Check();
+   }
+
+   // ::: Only JSON requests get the property, so every other request keeps the template's map. Finding
+   // --- Content-Type compares the C slices and builds no strings.
+   if (!request->body.ptr)
+      return req;
+   for (int i = 0; i < request->header_count; i++) {
+      const JSHeader& header = request->headers[i];
+      if (header.name.len != 12 || strncasecmp(header.name.ptr, "Content-Type", 12) != 0)
+         continue;
+      if (is_json_content_type(header.value))
+         req->SetLazyDataProperty(context, engine_key(engine, KEY_JSON), RequestJsonGetter).Check();
+      break;
+   }
+   return req;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Points a response body at the bytes of an ArrayBuffer or  *
+ * typed array without copying them. The backing store is    *
+ * kept alive through body_hold until v8_free_response.      *
+ *************************************************************
+ */
+static void set_binary_body(v8::Local<v8::Value> body, JSResponse* response)
+{
+   std::shared_ptr<v8::BackingStore> store;
+   size_t offset = 0, length = 0;
+   if (body->IsArrayBufferView()) {
+      v8::Local<v8::ArrayBufferView> view = body.As<v8::ArrayBufferView>();
+      store = view->Buffer()->GetBackingStore();
+      offset = view->ByteOffset();
+      length = view->ByteLength();
+   } else {
+      store = body.As<v8::ArrayBuffer>()->GetBackingStore();
+      length = store->ByteLength();
+   }
+   response->body_is_binary = 1;
+   if (!store->Data() || length == 0)
+      return;
+   response->body = JSSlice{static_cast<const char*>(store->Data()) + offset, length};
+   // ::: A shared_ptr<BackingStore> may be released on any thread, so the write can happen after unlocking.
+   response->body_hold = new std::shared_ptr<v8::BackingStore>(std::move(store));
+}
+
+// ::: A { file: path } body is an object whose only own property is a string `file`. Any other object is
+// --- sent as JSON, so a JSON body that merely has a `file` field is left alone.
+static bool file_body_path(V8Engine* engine,
+                           v8::Local<v8::Context> context,
+                           v8::Local<v8::Object> body,
+                           std::string* path)
+{
+   v8::Local<v8::Value> file;
+   v8::Local<v8::Array> names;
+   if (!body->Get(context, engine_key(engine, KEY_FILE)).ToLocal(&file) || !file->IsString() ||
+       !body->GetOwnPropertyNames(context).ToLocal(&names) || names->Length() != 1)
+      return false;
+   v8::String::Utf8Value utf8(engine->isolate, file);
+   *path = *utf8 ? *utf8 : "";
+   return true;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Copies { status, headers, body } of the handler's return  *
+ * value into a JSResponse. All strings share one malloc'd   *
+ * storage block; binary bodies are referenced, not copied.  *
+ * An object or array body is serialized with JSON.stringify *
+ * straight into that block, and gets a JSON Content-Type    *
+ * unless the handler set one.                               *
+ *************************************************************
+ */
+static JSDispatchResult fill_response(V8Engine* engine,
+                                      v8::Local<v8::Context> context,
+                                      v8::Local<v8::Value> value,
+                                      JSResponse* response)
+{
+   if (!value->IsObject())
+      return JS_DISPATCH_BAD_RESPONSE;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Local<v8::Object> obj = value.As<v8::Object>();
+
+   response->status = 200;
+   v8::Local<v8::Value> status;
+   if (obj->Get(context, engine_key(engine, KEY_STATUS)).ToLocal(&status) &&
+       status->IsNumber()) {
+      response->status = status->Int32Value(context).FromMaybe(200);
+   }
+
+   // ::: Gather every string first, so that the storage can be sized and allocated once.
+   std::vector<v8::Local<v8::String>> strings;
+   bool has_content_type = false;
+   v8::Local<v8::Value> headers;
+   if (obj->Get(context, engine_key(engine, KEY_HEADERS)).ToLocal(&headers) &&
+       headers->IsObject()) {
+      v8::Local<v8::Object> headers_obj = headers.As<v8::Object>();
+      v8::Local<v8::Array> names;
+      if (headers_obj->GetOwnPropertyNames(context).ToLocal(&names)) {
+         uint32_t count = std::min<uint32_t>(names->Length(), JS_RESPONSE_MAX_HEADERS);
+         for (uint32_t i = 0; i < count; i++) {
+            v8::Local<v8::Value> name, header_value;
+            v8::Local<v8::String> name_str, value_str;
+            if (!names->Get(context, i).ToLocal(&name) || !name->ToString(context).ToLocal(&name_str) ||
+                !headers_obj->Get(context, name).ToLocal(&header_value) ||
+                !header_value->ToString(context).ToLocal(&value_str)) {
+               continue;
+            }
+            strings.push_back(name_str);
+            strings.push_back(value_str);
+            if (!has_content_type && name_str->Length() == 12) {
+               v8::String::Utf8Value name_utf8(isolate, name_str);
+               has_content_type = *name_utf8 && strcasecmp(*name_utf8, "Content-Type") == 0;
+            }
+         }
+      }
+   }
+
+   v8::Local<v8::Value> body;
+   v8::Local<v8::String> body_str = v8::String::Empty(isolate);
+   bool binary_body = false;
+   bool file_body = false;
+   std::string file_path;
+   if (obj->Get(context, engine_key(engine, KEY_BODY)).ToLocal(&body) &&
+       !body->IsNullOrUndefined()) {
+      if (body->IsArrayBufferView() || body->IsArrayBuffer()) {
+         set_binary_body(body, response);
+         binary_body = true;
+      } else if (body->IsObject() && file_body_path(engine, context, body.As<v8::Object>(), &file_path)) {
+         // ::: Opened through the ASP.static cache; a missing file turns the default 200 into a 404.
+         response->file = static_file_open(file_path.c_str());
+         if (!response->file && response->status == 200)
+            response->status = 404;
+         file_body = true;
+      } else if (body->IsObject() && !body->IsStringObject()) {
+         if (!v8::JSON::Stringify(context, body).ToLocal(&body_str))
+            return JS_DISPATCH_EXCEPTION;
+         if (!has_content_type && strings.size() < 2 * JS_RESPONSE_MAX_HEADERS) {
+            strings.push_back(engine_key(engine, KEY_CONTENT_TYPE));
+            strings.push_back(engine_key(engine, KEY_JSON_MIME));
+         }
+      } else if (!body->ToString(context).ToLocal(&body_str)) {
+         return JS_DISPATCH_EXCEPTION;
+      }
+   }
+   if (!binary_body && !file_body)
+      strings.push_back(body_str);
+
+   size_t total = 0;
+   std::vector<size_t> lengths(strings.size());
+   for (size_t i = 0; i < strings.size(); i++) {
+      lengths[i] = strings[i]->Utf8Length(isolate);
+      total += lengths[i];
+   }
+   response->storage = (char*)malloc(total + 1);
+   if (!response->storage)
+      return JS_DISPATCH_BAD_RESPONSE;
+
+   char* cursor = response->storage;
+   JSSlice slices[2 * JS_RESPONSE_MAX_HEADERS + 1];
+   for (size_t i = 0; i < strings.size(); i++) {
+      // ::: An all-ASCII one-byte string is already its own UTF-8 encoding, so take the plain copy.
+      if (strings[i]->IsOneByte() && lengths[i] == (size_t)strings[i]->Length()) {
+         strings[i]->WriteOneByte(
+            isolate, reinterpret_cast<uint8_t*>(cursor), 0, (int)lengths[i], v8::String::NO_NULL_TERMINATION);
+      } else {
+         strings[i]->WriteUtf8(isolate,
+                               cursor,
+                               (int)lengths[i],
+                               nullptr,
+                               v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+      }
+      slices[i] = JSSlice{cursor, lengths[i]};
+      cursor += lengths[i];
+   }
+   *cursor = '\0';
+
+   response->header_count = (int)(strings.size() - (binary_body || file_body ? 0 : 1)) / 2;
+   for (int i = 0; i < response->header_count; i++) {
+      response->headers[i].name = slices[2 * i];
+      response->headers[i].value = slices[2 * i + 1];
+   }
+   if (!binary_body && !file_body)
+      response->body = slices[strings.size() - 1];
+   return JS_DISPATCH_OK;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Publishes `request` to the lazy request fields for the    *
+ * length of one dispatch. On the way out it is withdrawn    *
+ * and the bridge drops its reference to an adopted body,    *
+ * which then lives exactly as long as the strings and       *
+ * ArrayBuffers made from it.                                *
+ *************************************************************
+ */
+class ActiveRequest
 {
  public:
-   V8Locker(v8::Isolate* isolate) : locker_(isolate) {}
+   ActiveRequest(V8Engine* engine, JSRequest* request) : engine_(engine)
+   {
+      engine->active_request = request;
+      // ::: Kept within Smi range, so stamping it into a request object never allocates.
+      engine->request_generation = (engine->request_generation + 1) & 0x3fffffff;
+   }
+
+   ~ActiveRequest()
+   {
+      engine_->active_request = nullptr;
+      if (engine_->active_body) {
+         release_body_owner(engine_->active_body);
+         engine_->active_body = nullptr;
+      }
+   }
 
  private:
-   v8::Locker locker_;
+   V8Engine* engine_;
 };
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3
- *
- * Ensures that a function is executed with the V8 engine's thread-safety
- * mechanism (v8::Locker). This is crucial when using V8 in a multi-threaded
- * environment, as only one thread may access a V8 Isolate at a time.
- *
- * Steps performed by this function:
- *   1. Acquires a v8::Locker for the given V8 Isolate, ensuring exclusive
- * access to the V8 engine for the current thread.
- *   2. Calls the provided function pointer `fn`, passing it the `data`
- * argument.
- *   3. Returns the result of the function call.
- *
- * APIs and system calls used:
- *   - v8::Locker: Locks the V8 Isolate for the current thread, ensuring thread
- * safety.
- *   - Function pointer invocation: Calls the user-provided function with the
- * given data.
- *
- * Note: The implementation of this function is in principle correct, but it is
- * the student's responsibility to identify where this method should be used in
- * the context of the M3 milestone to ensure proper synchronization on the V8
- * engine in multi-threaded scenarios.
- *
- * Note: It is the responsibility of the function being called (`fn`) to cast
- * the `void *data` argument to the appropriate struct type.
- *
- * Example usage:
- *   // Define a struct for arguments
- *   typedef struct {
- *       int a;
- *       int b;
- *   } Args;
- *
- *   // Example function to be called
- *   int add_args(void* data) {
- *       Args* args = (Args*)data;
- *       return args->a + args->b;
- *   }
- *
- *   // Usage
- *   Args args = {2, 3};
- *   int sum = invoke_with_v8_locker(engine, add_args, &args);
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Called when a handler goes async. The C request is gone   *
+ * once the dispatch returns, so every lazy field still      *
+ * unread is read now, and the headers are copied onto the   *
+ * headers object as own properties, which the interceptor   *
+ * gives way to.                                             *
+ *************************************************************
+ */
+static void materialize_request(V8Engine* engine, v8::Local<v8::Context> context, v8::Local<v8::Object> req)
+{
+   v8::Isolate* isolate = engine->isolate;
+   static const EngineKey lazy_fields[] = {KEY_BODY, KEY_BODY_BUFFER, KEY_QUERY};
+   for (EngineKey key : lazy_fields) {
+      if (req->Get(context, engine_key(engine, key)).IsEmpty())
+         return;
+   }
+   v8::Local<v8::Value> value;
+   if (!req->Get(context, engine_key(engine, KEY_HEADERS)).ToLocal(&value) || !value->IsObject())
+      return;
+   JSRequest* request = engine->active_request;
+   v8::Local<v8::Object> headers = value.As<v8::Object>();
+   for (int i = 0; i < request->header_count; i++) {
+      const JSHeader& header = request->headers[i];
+      if (headers
+             ->CreateDataProperty(
+                context, slice_to_string(isolate, header.name), slice_to_string(isolate, header.value))
+             .IsNothing())
+         return;
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Calls the matched route's function, or the createServer   *
+ * handler when no route matched, with `req`. On an          *
+ * exception the message is printed and false is returned; a *
+ * watchdog termination is left to the caller's              *
+ * ExecutionBudget to report.                                *
+ *************************************************************
+ */
+static bool call_handler(V8Engine* engine,
+                         v8::Local<v8::Context> context,
+                         const RouteMatch& match,
+                         v8::Local<v8::Object> req,
+                         v8::Local<v8::Value>* result)
+{
+   v8::Isolate* isolate = engine->isolate;
+   v8::TryCatch try_catch(isolate);
+   v8::Local<v8::Function> handler =
+      match.handler >= 0
+         ? engine->route_handlers[match.handler].Get(isolate)
+         : v8::Local<v8::Object>::New(isolate, engine->g_server_handler.handler->handle).As<v8::Function>();
+   v8::Local<v8::Value> argv[] = {req};
+   if (!handler->Call(context, context->Global(), 1, argv).ToLocal(result)) {
+      if (try_catch.HasTerminated())
+         return false;
+      v8::String::Utf8Value exception(isolate, try_catch.Exception());
+      fprintf(stderr, "Uncaught exception in request handler: %s\n", *exception ? *exception : "<unknown>");
+      return false;
+   }
+   return true;
+}
+
+static void report_rejection(v8::Isolate* isolate, v8::Local<v8::Value> reason)
+{
+   v8::String::Utf8Value message(isolate, reason);
+   fprintf(stderr, "Unhandled rejection in request handler: %s\n", *message ? *message : "<unknown>");
+}
+
+// ::: True if `rest`, a decoded path below a mount, has a ".." segment that could climb out of it.
+static bool escapes_mount(const std::string& rest)
+{
+   for (size_t pos = 0; (pos = rest.find("..", pos)) != std::string::npos; pos += 2) {
+      if ((pos == 0 || rest[pos - 1] == '/') && (pos + 2 == rest.size() || rest[pos + 2] == '/'))
+         return true;
+   }
+   return false;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Answers GET and HEAD requests under an ASP.static mount   *
+ * straight from the open-file cache, before routes and      *
+ * without entering V8. Returns false if no mount has the    *
+ * file, and the request goes on to the routes and the       *
+ * handler.                                                  *
+ *************************************************************
+ */
+static bool serve_static(V8Engine* engine, JSRequest* request, JSResponse* response)
+{
+   JSSlice method = request->method;
+   JSSlice path = request->path;
+   if (engine->static_mounts.empty() || !path.ptr ||
+       !((method.len == 3 && memcmp(method.ptr, "GET", 3) == 0) ||
+         (method.len == 4 && memcmp(method.ptr, "HEAD", 4) == 0)))
+      return false;
+
+   const char* query = static_cast<const char*>(memchr(path.ptr, '?', path.len));
+   size_t path_len = query ? (size_t)(query - path.ptr) : path.len;
+   std::string rest;
+   for (const auto& mount : engine->static_mounts) {
+      const std::string& prefix = mount.first;
+      size_t skip = prefix == "/" ? 0 : prefix.size();
+      if (path_len < prefix.size() || memcmp(path.ptr, prefix.data(), prefix.size()) != 0 ||
+          (path_len > skip && path.ptr[skip] != '/'))
+         continue;
+      decode_url_component(path.ptr + skip, path_len - skip, false, rest);
+      if (rest.find('\0') != std::string::npos || escapes_mount(rest))
+         continue;
+      if (rest.empty() || rest.back() == '/')
+         rest += rest.empty() ? "/index.html" : "index.html";
+      if (StaticFile* file = static_file_open((mount.second + rest).c_str())) {
+         response->status = 200;
+         response->file = file;
+         return true;
+      }
+   }
+   return false;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Picks the function for `request` before anything enters   *
+ * V8. Without a match, requests fall through to the         *
+ * createServer handler if there is one; otherwise the table *
+ * answers 404 or 405 (with Allow) itself and false is       *
+ * returned, so no JS runs at all.                           *
+ *************************************************************
+ */
+static bool route_request(V8Engine* engine, JSRequest* request, JSResponse* response, RouteMatch* match)
+{
+   match->handler = -1;
+   match->param_count = 0;
+   if (engine->routes.count == 0 && engine->g_server_handler.handler)
+      return true;
+
+   JSSlice path = request->path;
+   const char* query = path.ptr ? static_cast<const char*>(memchr(path.ptr, '?', path.len)) : nullptr;
+   RouteResult result = route_table_lookup(&engine->routes,
+                                           request->method.ptr,
+                                           request->method.len,
+                                           path.ptr,
+                                           query ? (size_t)(query - path.ptr) : path.len,
+                                           match);
+   if (result == ROUTE_FOUND || engine->g_server_handler.handler)
+      return true;
+
+   response->status = result == ROUTE_METHOD_NOT_ALLOWED ? 405 : 404;
+   if (result == ROUTE_METHOD_NOT_ALLOWED) {
+      char allow[64];
+      size_t len = route_allow_header(match->allowed, allow, sizeof(allow));
+      response->storage = (char*)malloc(len + 1);
+      if (response->storage) {
+         memcpy(response->storage, allow, len + 1);
+         response->headers[0] = JSHeader{JSSlice{"Allow", 5}, JSSlice{response->storage, len}};
+         response->header_count = 1;
+      }
+   }
+   return false;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Runs one request through the registered handler in a      *
+ * single crossing: one set of scopes builds the request as  *
+ * Locals, calls the handler and copies out the response.    *
+ *************************************************************
+ */
+static JSDispatchResult dispatch_request(V8Engine* engine, JSRequest* request, JSResponse* response)
+{
+   memset(response, 0, sizeof(*response));
+   if (!engine->isolate || !request || !engine->g_server_handler.is_set)
+      return JS_DISPATCH_NO_HANDLER;
+   if (serve_static(engine, request, response))
+      return JS_DISPATCH_OK;
+   RouteMatch match;
+   if (!route_request(engine, request, response, &match))
+      return JS_DISPATCH_OK;
+
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = v8::Local<v8::Context>::New(isolate, engine->context);
+   v8::Context::Scope context_scope(context);
+
+   ActiveRequest active(engine, request);
+   v8::Local<v8::Object> req = build_request_object(engine, context, request, &match);
+   v8::Local<v8::Value> result;
+   if (!call_handler(engine, context, match, req, &result))
+      return JS_DISPATCH_EXCEPTION;
+
+   // ::: An async handler that only awaits other promises settles within one checkpoint. Anything that
+   // --- waits on I/O or timers cannot be served by a blocking caller.
+   if (result->IsPromise()) {
+      v8::Local<v8::Promise> promise = result.As<v8::Promise>();
+      if (promise->State() == v8::Promise::kPending)
+         isolate->PerformMicrotaskCheckpoint();
+      if (promise->State() == v8::Promise::kRejected) {
+         report_rejection(isolate, promise->Result());
+         return JS_DISPATCH_EXCEPTION;
+      }
+      if (promise->State() == v8::Promise::kPending)
+         return JS_DISPATCH_BAD_RESPONSE;
+      result = promise->Result();
+   }
+
+   JSDispatchResult status = fill_response(engine, context, result, response);
+   if (status != JS_DISPATCH_OK)
+      v8_free_response(response);
+   return status;
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Promise reactions of a parked handler: copy the response  *
+ * out (or report the rejection) and hand it to the caller's *
+ * callback. A token no longer in the table belongs to a     *
+ * cancelled dispatch, and the settle is dropped.            *
+ *************************************************************
+ */
+static void settle_dispatch(const v8::FunctionCallbackInfo<v8::Value>& args, bool fulfilled)
+{
+   v8::Isolate* isolate = args.GetIsolate();
+   auto* engine = static_cast<V8Engine*>(isolate->GetData(0));
+   auto it = engine->pending_dispatches.find(args.Data().As<v8::BigInt>()->Uint64Value());
+   if (it == engine->pending_dispatches.end())
+      return;
+   PendingDispatch pending = it->second;
+   engine->pending_dispatches.erase(it);
+   v8::TryCatch try_catch(isolate);
+   JSResponse response;
+   memset(&response, 0, sizeof(response));
+   JSDispatchResult status = JS_DISPATCH_EXCEPTION;
+   if (fulfilled) {
+      status = fill_response(engine, isolate->GetCurrentContext(), args[0], &response);
+      if (status != JS_DISPATCH_OK)
+         v8_free_response(&response);
+   } else {
+      report_rejection(isolate, args[0]);
+   }
+   pending.callback(pending.ctx, status, &response);
+}
+
+static void DispatchFulfilledCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+   settle_dispatch(args, true);
+}
+
+static void DispatchRejectedCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+   settle_dispatch(args, false);
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Same crossing as v8_dispatch_request, but a pending       *
+ * promise is parked on two reactions instead of waited on.  *
+ *************************************************************
  */
-int invoke_with_v8_locker(V8Engine* engine, generic_func_t fn, void* data)
+static JSDispatchResult dispatch_request_async(V8Engine* engine,
+                                               JSRequest* request,
+                                               JSResponse* response,
+                                               JSResponseCallback callback,
+                                               void* ctx,
+                                               uint64_t* token)
 {
-   V8Locker locker(engine->isolate);
-   return fn(data);
+   memset(response, 0, sizeof(*response));
+   if (!engine->isolate || !request || !engine->g_server_handler.is_set)
+      return JS_DISPATCH_NO_HANDLER;
+   if (serve_static(engine, request, response))
+      return JS_DISPATCH_OK;
+   RouteMatch match;
+   if (!route_request(engine, request, response, &match))
+      return JS_DISPATCH_OK;
+
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = v8::Local<v8::Context>::New(isolate, engine->context);
+   v8::Context::Scope context_scope(context);
+
+   ActiveRequest active(engine, request);
+   v8::Local<v8::Object> req = build_request_object(engine, context, request, &match);
+   v8::Local<v8::Value> result;
+   if (!call_handler(engine, context, match, req, &result))
+      return JS_DISPATCH_EXCEPTION;
+
+   if (result->IsPromise()) {
+      v8::Local<v8::Promise> promise = result.As<v8::Promise>();
+      switch (promise->State()) {
+      case v8::Promise::kFulfilled:
+         result = promise->Result();
+         break;
+      case v8::Promise::kRejected:
+         report_rejection(isolate, promise->Result());
+         return JS_DISPATCH_EXCEPTION;
+      case v8::Promise::kPending: {
+         materialize_request(engine, context, req);
+         uint64_t id = ++engine->next_dispatch_token;
+         engine->pending_dispatches.emplace(id, PendingDispatch{callback, ctx});
+         v8::Local<v8::BigInt> data = v8::BigInt::NewFromUnsigned(isolate, id);
+         v8::Local<v8::Function> on_fulfilled, on_rejected;
+         if (!v8::Function::New(context, DispatchFulfilledCallback, data).ToLocal(&on_fulfilled) ||
+             !v8::Function::New(context, DispatchRejectedCallback, data).ToLocal(&on_rejected) ||
+             promise->Then(context, on_fulfilled, on_rejected).IsEmpty()) {
+            engine->pending_dispatches.erase(id);
+            return JS_DISPATCH_EXCEPTION;
+         }
+         *token = id;
+         return JS_DISPATCH_PENDING;
+      }
+      }
+   }
+
+   JSDispatchResult status = fill_response(engine, context, result, response);
+   if (status != JS_DISPATCH_OK)
+      v8_free_response(response);
+   return status;
 }
 
 /*
@@ -1016,167 +4305,216 @@ int invoke_with_v8_locker(V8Engine* engine, generic_func_t fn, void* data)
  *   ██║  ██║███████║██║                                     *
  *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
  *                                                           *
- * Returns a pointer to the server handler function.         *
+ * ASP.createBatchServer: hands every job that reaches the   *
+ * handler to it in one array and copies the returned array  *
+ * back out, element by element. Static files, native        *
+ * 404/405s and ASP.route matches are answered one at a time *
+ * as usual. Called inside v8_dispatch_batch's scopes.       *
  *************************************************************
  */
-void* v8_get_registered_handler_func(V8Engine* engine)
+static void dispatch_batch_call(V8Engine* engine,
+                                v8::Local<v8::Context> context,
+                                JSDispatchJob* const* jobs,
+                                size_t count)
 {
-   if (!engine->g_server_handler.is_set)
-      return nullptr;
-   return &engine->g_server_handler.handler;
+   v8::Isolate* isolate = engine->isolate;
+   v8::Local<v8::Array> requests = v8::Array::New(isolate);
+   JSDispatchJob* batched[BATCH_SERVER_MAX];
+   uint32_t batched_count = 0;
+   for (size_t i = 0; i < count; ++i) {
+      JSDispatchJob* job = jobs[i];
+      memset(job->response, 0, sizeof(*job->response));
+      job->result = JS_DISPATCH_OK;
+      RouteMatch match;
+      if (serve_static(engine, job->request, job->response) ||
+          !route_request(engine, job->request, job->response, &match))
+         continue;
+      if (match.handler >= 0) {
+         ExecutionBudget budget(engine);
+         job->result = budget.settle(dispatch_request(engine, job->request, job->response), job->response);
+         continue;
+      }
+      // ::: The C requests are all gone by the time the handler runs, so each is read in full up front.
+      ActiveRequest active(engine, job->request);
+      v8::Local<v8::Object> req = build_request_object(engine, context, job->request, &match);
+      materialize_request(engine, context, req);
+      requests->Set(context, batched_count, req).Check();
+      batched[batched_count++] = job;
+   }
+   if (batched_count == 0)
+      return;
+
+   ExecutionBudget budget(engine);
+   RouteMatch match;
+   match.handler = -1;
+   v8::Local<v8::Value> result;
+   JSDispatchResult status = JS_DISPATCH_OK;
+   if (!call_handler(engine, context, match, requests, &result)) {
+      status = JS_DISPATCH_EXCEPTION;
+   } else if (result->IsPromise()) {
+      // ::: As with createServer, an async batch handler must settle within one checkpoint.
+      v8::Local<v8::Promise> promise = result.As<v8::Promise>();
+      if (promise->State() == v8::Promise::kPending)
+         isolate->PerformMicrotaskCheckpoint();
+      if (promise->State() == v8::Promise::kRejected) {
+         report_rejection(isolate, promise->Result());
+         status = JS_DISPATCH_EXCEPTION;
+      } else if (promise->State() == v8::Promise::kPending) {
+         status = JS_DISPATCH_BAD_RESPONSE;
+      } else {
+         result = promise->Result();
+      }
+   }
+   if (status == JS_DISPATCH_OK && !result->IsArray()) {
+      fprintf(stderr, "Batch handler must return an array of responses\n");
+      status = JS_DISPATCH_BAD_RESPONSE;
+   }
+
+   // ::: Element i answers request i; a missing or malformed element fails only its own request.
+   v8::Local<v8::Array> responses;
+   if (status == JS_DISPATCH_OK)
+      responses = result.As<v8::Array>();
+   for (uint32_t i = 0; i < batched_count; ++i) {
+      JSDispatchJob* job = batched[i];
+      v8::Local<v8::Value> value;
+      if (status != JS_DISPATCH_OK)
+         job->result = status;
+      else if (!responses->Get(context, i).ToLocal(&value))
+         job->result = JS_DISPATCH_EXCEPTION;
+      else
+         job->result = fill_response(engine, context, value, job->response);
+      if (job->result != JS_DISPATCH_OK)
+         v8_free_response(job->response);
+   }
+   if (budget.disarm()) {
+      fprintf(stderr,
+              "Request handler exceeded its %zu ms budget and was terminated\n",
+              engine_config.limits.request_budget_ms);
+      for (uint32_t i = 0; i < batched_count; ++i) {
+         if (batched[i]->result == JS_DISPATCH_OK)
+            v8_free_response(batched[i]->response);
+         batched[i]->result = JS_DISPATCH_TIMEOUT;
+      }
+   }
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M4 (used in M5 as well)
- *
- * Calls a JavaScript function with no arguments and returns the result as a
- * JSResult.
- *
- * Implementation hints:
- *   1. Checks if the input function object is valid (not null).
- *   2. Set up the V8 isolate and context scopes for the current thread.
- *   3. Retrieve the function object from the global handler.
- *   4. Call the function with no arguments and retrieve the result.
- *   5. Processes the result:
- *      - If it's a string, store it in result.value.str_result and set
- * result.type to JS_STRING.
- *      - Handle other types accordingly.
- *   9. Return the JSResult containing success status and value.
- *
- * V8 APIs that you may need:
- * - Scope management: v8::Isolate::Scope, v8::HandleScope, v8::Context::Scope
- * - Context and object handling: v8::Local<v8::Context>::New,
- * v8::Local<v8::Object>::New
- * - Function handling: v8::Local<v8::Function>::As, v8::Function::Call
- * - Value handling: v8::Value::IsString, IsNumber, IsObject, IsNull,
- * IsUndefined
- * - String and number creation: v8::String::Utf8Value
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Public dispatch entry points. Each runs the handler, its  *
+ * first microtask checkpoint and the response copy under    *
+ * one execution budget.                                     *
+ *************************************************************
  */
-JSResult v8_call_function_no_arguments(V8Engine* engine, JSObject fun)
+JSDispatchResult v8_dispatch_request(V8Engine* engine, JSRequest* request, JSResponse* response)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return {0};
+   ExecutionBudget budget(engine);
+   return budget.settle(dispatch_request(engine, request, response), response);
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M3 (used in M4 as well)
- *
- * Calls the currently registered server handler JavaScript function,
- * passing it a single JavaScript object argument, and returns the result as a
- * JSResult.
- *
- * The implementation of this function is analogous to that of
- * v8_call_function_no_arguments, but it calls the registered handler function
- * with a single JS object argument instead of no arguments.
- *
- * The handler function is expected to be registered in the engine's global
- * state (V8Engine struct).
+int v8_serve_static(V8Engine* engine, JSRequest* request, JSResponse* response)
+{
+   memset(response, 0, sizeof(*response));
+   return engine && request && serve_static(engine, request, response);
+}
+
+JSDispatchResult v8_dispatch_request_async(V8Engine* engine,
+                                           JSRequest* request,
+                                           JSResponse* response,
+                                           JSResponseCallback callback,
+                                           void* ctx,
+                                           uint64_t* token)
+{
+   ExecutionBudget budget(engine);
+   return budget.settle(dispatch_request_async(engine, request, response, callback, ctx, token), response);
+}
+
+void v8_cancel_dispatch(V8Engine* engine, uint64_t token)
+{
+   engine->pending_dispatches.erase(token);
+}
+
+void v8_dispatch_batch(V8Engine* engine, JSDispatchJob* const* jobs, size_t count)
+{
+   // ::: Entered once here, the per-request scopes inside dispatch_request are only bookkeeping. Each
+   // --- request still gets its own HandleScope, so a large batch does not pile up handles.
+   v8::Isolate* isolate = engine->isolate;
+   v8::Isolate::Scope isolate_scope(isolate);
+   v8::HandleScope handle_scope(isolate);
+   v8::Local<v8::Context> context = v8::Local<v8::Context>::New(isolate, engine->context);
+   v8::Context::Scope context_scope(context);
+   size_t batch = (size_t)engine->g_server_handler.options.batch;
+   if (batch > 0 && engine->g_server_handler.handler) {
+      for (size_t i = 0; i < count; i += batch)
+         dispatch_batch_call(engine, context, jobs + i, std::min(batch, count - i));
+      return;
+   }
+   for (size_t i = 0; i < count; ++i) {
+      ExecutionBudget budget(engine);
+      jobs[i]->result = budget.settle(dispatch_request(engine, jobs[i]->request, jobs[i]->response),
+                                      jobs[i]->response);
+   }
+}
+
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Drains the isolate's microtask queue. A checkpoint that   *
+ * overruns the budget is terminated and V8 drops the        *
+ * reactions it did not reach; their parked requests then    *
+ * run into their deadline.                                  *
+ *************************************************************
  */
-JSResult v8_call_registered_handler_obj(V8Engine* engine, JSObject arg)
+void v8_run_microtasks(V8Engine* engine)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return {0};
+   v8::Isolate::Scope isolate_scope(engine->isolate);
+   ExecutionBudget budget(engine);
+   engine->isolate->PerformMicrotaskCheckpoint();
+   if (budget.disarm())
+      fprintf(stderr,
+              "Microtask checkpoint exceeded its %zu ms budget and was terminated\n",
+              engine_config.limits.request_budget_ms);
 }
 
-/**
- *   __  __
- *  |  \/  |
- *  | \  / |
- *  | |\/| |
- *  | |  | |
- *  |_|  |_| M2
- *
- *
- * Calls the currently registered server handler JavaScript function with a
- * single string argument.
- *
- * This function is intended to invoke a JavaScript handler (previously
- * registered via ASP server creation) by passing it a string argument
- * (`method`). It returns a `JSResult` containing the result of the JS function
- * call, which may be a string, number, or object (object results are not used
- * in this context).
- *
- * Implementation hints:
- *   1. Check if the `method` argument is valid (not null).
- *   2. Check if a server handler is registered.
- *   3. Set up the V8 isolate and context scopes.
- *   4. Retrieve the registered handler function from the global context.
- *   5. Convert the `method` string to a V8 string.
- *   6. Call the handler function with the `method` argument.
- *   7. Processe the result of the function call:
- *      - If the result is a string, it stores it in `result.value.str_result
- *          and sets `result.type` to `JS_STRING`.
- *      - If the result is a number, it stores it in `result.value.int_result`
- *          and sets `result.type` to `JS_NUMBER`.
- *      - If the result is an object, it creates a new `JSObjectHandle` and sets
- * `result.value.obj_result` (though this is not used in this context).
- *              * If the result is null or undefined, it sets `result.type`
- * accordingly.
- *              * Finally, it returns the `JSResult` containing the success
- * status and result value.
- *
- * V8 APIs that you may need:
- * - v8::Isolate::Scope -> Initializes the V8 isolate scope for the current
- * thread.
- * - v8::HandleScope -> Creates a handle scope to manage V8 handles.
- * - v8::Context::Scope -> Sets the current context for V8 operations.
- * - v8::Local\<v8::Object\>::New -> Creates a local handle to a V8 object.
- * - v8::Local\<v8::Function\>::As -> Casts a local handle to a V8 function.
- * - v8::String::NewFromUtf8 -> Converts a C-style string to a V8 string.
- * - v8::Function::Call -> Invokes a V8 function with the specified context,
- * receiver, and arguments.
- * - v8::Value::IsString, IsNumber, IsObject -> Checks the type of a V8 value.
- * - v8::String::Utf8Value -> Converts a V8 string to a UTF-8 encoded C-style
- * string.
- *
- * @param engine Pointer to the V8Engine instance.
- * @param method The string argument to pass to the handler function.
- * @return JSResult containing the result of the handler invocation.
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Releases the storage behind a JSResponse.                 *
+ *************************************************************
  */
-JSResult v8_call_registered_handler_string(V8Engine* engine, const char* method)
+void v8_free_response(JSResponse* response)
 {
-   /**
-       ┏━━━━┓┏━━━┓━┏━━━┓┏━━━┓
-       ┃┏┓┏┓┃┃┏━┓┃━┗┓┏┓┃┃┏━┓┃
-       ┗┛┃┃┗┛┃┃━┃┃ ━┃┃┃┃┃┃━┃┃
-       ━━┃┃━━┃┃━┃┃━━┃┃┃┃┃┃━┃┃
-       ━┏┛┗┓━┃┗━┛┃━┏┛┗┛┃┃┗━┛┃
-       ━┗━━┛━┗━━━┛━┗━━━┛┗━━━┛
-       ━━━━━━━━━━━━━━━━━━━━━
-       ━━━ Your code here...
-       ━━━━━━━━━━━━━━━━━━━━━
-       */
-   return {0};
+   if (!response)
+      return;
+   free(response->storage);
+   response->storage = nullptr;
+   delete static_cast<std::shared_ptr<v8::BackingStore>*>(response->body_hold);
+   response->body_hold = nullptr;
+   static_file_release(response->file);
+   response->file = nullptr;
+   response->header_count = 0;
+   response->body = JSSlice{nullptr, 0};
 }
 
 /*
@@ -1194,4 +4532,19 @@ JSResult v8_call_registered_handler_string(V8Engine* engine, const char* method)
  */
 HTTPServerType v8_get_server_type(V8Engine* engine) { return engine->g_server_handler.server_type; }
 
+/*
+ *************************************************************
+ *                                                           *
+ *    █████╗ ███████╗██████╗                                 *
+ *   ██╔══██╗██╔════╝██╔══██╗                                *
+ *   ███████║███████╗██████╔╝                                *
+ *   ██╔══██║╚════██║██╔═══╝                                 *
+ *   ██║  ██║███████║██║                                     *
+ *   ╚═╝  ╚═╝╚══════╝╚═╝                                     *
+ *                                                           *
+ * Returns the options passed to ASP.create*Server.          *
+ *************************************************************
+ */
+const ServerOptions* v8_get_server_options(V8Engine* engine) { return &engine->g_server_handler.options; }
+
 } // extern "C"